@@ -14,6 +14,75 @@
 #define SMX_INDEGREE_smx_rn 0
 #define SMX_OUTDEGREE_smx_rn 0
 
+/** The maximal number of key extractors which can be registered */
+#define SMX_RN_MAX_EXTRACTORS 16
+
+typedef enum smx_rn_mode_e smx_rn_mode_t;             /**< #smx_rn_mode_e */
+/** ::net_smx_rn_state_s */
+typedef struct net_smx_rn_state_s net_smx_rn_state_t;
+typedef struct smx_rn_route_s smx_rn_route_t;         /**< ::smx_rn_route_s */
+/** The key extractor function signature of a partitioning routing node */
+typedef const void* (*smx_rn_key_extractor_t)( smx_msg_t* msg, size_t* len );
+
+/**
+ * The routing mode of a routing node, i.e. to which outputs a message is
+ * written.
+ */
+enum smx_rn_mode_e
+{
+    SMX_RN_MODE_BROADCAST = 0,  /**< copy the message to every output */
+    SMX_RN_MODE_ROUND_ROBIN,    /**< the next output in turn with space */
+    SMX_RN_MODE_LEAST_LOADED,   /**< the output with the least messages */
+    SMX_RN_MODE_FIRST_READY,    /**< the first output with an empty FIFO */
+    SMX_RN_MODE_CONTENT,        /**< the outputs given by the routing table */
+    SMX_RN_MODE_PARTITION       /**< the output given by the key hash */
+};
+
+/**
+ * An entry of the routing table of a routing node.
+ */
+struct smx_rn_route_s
+{
+    int count;      /**< the number of output ports */
+    int* ports;     /**< the indices of the output ports */
+};
+
+/**
+ * The persistent state to be passed to each iteration.
+ */
+struct net_smx_rn_state_s
+{
+    int             last_idx;   /**< the input port index of the last read */
+    int             next_out;   /**< the output port index to start at */
+    smx_rn_mode_t   mode;       /**< config argument for the routing mode */
+    unsigned long   blocked;    /**< number of msgs with no free output */
+    unsigned long   dropped;    /**< number of msgs without a route */
+    unsigned long   unkeyed;    /**< number of msgs without a key */
+    char*           field;      /**< the BSON path of the route or key field */
+    smx_hmap_t*     types;      /**< routes by message type */
+    smx_hmap_t*     values;     /**< routes by the value of the field */
+    smx_rn_route_t* fallback;   /**< the route of unmatched messages */
+    smx_rn_key_extractor_t extractor; /**< the key extractor of the partition */
+};
+
+/**
+ * Register a key extractor for partitioning routing nodes. A routing node
+ * selects the extractor by its name with the config argument
+ * `partition.extractor`. All extractors must be registered before the nets
+ * are started.
+ *
+ * @param name      the name of the extractor. The string is not copied and
+ *                  must remain valid until the program terminates.
+ * @param extractor the extractor function. It returns a pointer to the key of
+ *                  a message and writes the key length to its second argument
+ *                  or returns NULL if the message has no key. It is called
+ *                  by the net thread of the routing node and must not keep
+ *                  the message.
+ * @return          0 on success, -1 on failure
+ */
+int smx_rn_register_key_extractor( const char* name,
+        smx_rn_key_extractor_t extractor );
+
 /**
  * Connect a routing node to a channel
  *
@@ -46,6 +115,29 @@ void smx_net_init_rn( smx_net_t* rn );
  * in order how they appear in the list. Writing is blocking. All outputs must
  * be written before new input is accepted.
  *
+ * With the config argument `mode` set to `round_robin`, `least_loaded`, or
+ * `first_ready` the routing node distributes the messages instead: each
+ * message is written to exactly one output which has space in its FIFO,
+ * without a copy. Only if no output has space the routing node blocks on the
+ * output chosen by the mode.
+ *
+ * With the mode `content` the routing node writes each message only to the
+ * outputs given by its routing table (config argument `routes`): a message
+ * is routed by the value of the BSON field `routes.field` in its payload if
+ * the payload is a BSON document with this field and the value has a route,
+ * else by its message type, and else to the `routes.default` outputs. A
+ * message without any route is dismissed. Outputs are referred to by their
+ * port index.
+ *
+ * With the mode `partition` the routing node writes each message to exactly
+ * one output which is selected by the hash of a message key. The key is
+ * either returned by the key extractor registered with the name
+ * `partition.extractor` (see smx_rn_register_key_extractor()) or the value of
+ * the BSON field `partition.key` in the payload. The outputs are selected by
+ * a jump consistent hash: all messages with the same key are written to the
+ * same output as long as the number of outputs does not change. Messages
+ * without a key are handled as messages with an empty key.
+ *
  * In order to provide fairness the routing node remembers the last port index
  * from which a message was read. The next time the rn is executed it will
  * search for available messages starting from the last port index +1. This
@@ -58,8 +150,9 @@ void smx_net_init_rn( smx_net_t* rn );
 int smx_rn( void* h, void* state );
 
 /**
- * Initialises the routing node. The state is allocated with an integer which
- * is used to remember the last port index from which a message was read.
+ * Initialises the routing node. The state remembers the last port index from
+ * which a message was read, the routing mode, and the output to start the
+ * search for a free output.
  *
  * @param h     pointer to the net handler
  * @param state pointer to the state variable
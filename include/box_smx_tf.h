@@ -18,6 +18,9 @@
 typedef struct net_smx_tf_s net_smx_tf_t;             /**< ::net_smx_tf_s */
 typedef struct net_smx_tf_state_s net_smx_tf_state_t; /**< ::net_smx_tf_state_s */
 typedef struct smx_timer_s smx_timer_t;               /**< ::smx_timer_s */
+typedef struct smx_tf_slot_s smx_tf_slot_t;           /**< ::smx_tf_slot_s */
+typedef struct smx_tf_stats_s smx_tf_stats_t;         /**< ::smx_tf_stats_s */
+typedef struct smx_tf_shard_s smx_tf_shard_t;         /**< ::smx_tf_shard_s */
 
 /**
  * @brief The signature of a temporal firewall
@@ -26,9 +29,38 @@ struct net_smx_tf_s
 {
     smx_channel_t*      in;         /**< input channel */
     smx_channel_t*      out;        /**< output channel */
+    uint64_t            period;     /**< propagation period in ns */
+    uint64_t            phase;      /**< offset of the first propagation in ns */
     net_smx_tf_t*       next;       /**< pointer to the next element */
 };
 
+/**
+ * @brief An instant of the dispatch table of a temporal firewall
+ *
+ * The dispatch table holds all instants within one hyperperiod at which at
+ * least one port pair is due.
+ */
+struct smx_tf_slot_s
+{
+    uint64_t            offset;     /**< offset from the hyperperiod start */
+    int                 count;      /**< number of due port pairs */
+    int*                pairs;      /**< port indices of the due pairs */
+};
+
+/**
+ * @brief The timing statistics of a temporal firewall
+ *
+ * The wake-up lateness is measured against the ideal instant of the dispatch
+ * table, i.e. it includes the timer resolution and the scheduling latency.
+ */
+struct smx_tf_stats_s
+{
+    uint64_t            dispatches; /**< number of dispatched instants */
+    uint64_t            missed;     /**< instants which were already due */
+    smx_hist_t          wakeup;     /**< the wake-up lateness in ns */
+    smx_hist_t          propagation;/**< the propagation time in ns */
+};
+
 /**
  * @brief A Streamix timer structure
  *
@@ -36,10 +68,41 @@ struct net_smx_tf_s
  */
 struct smx_timer_s
 {
-    int                 fd;         /**< timer file descriptor */
+    int                 fd;         /**< timer file descriptor (RT only) */
     struct itimerspec   itval;      /**< iteration specifiaction */
     net_smx_tf_t*       tfs;        /**< list of temporal firewalls */
     int                 count;      /**< number of port pairs */
+    uint64_t            hyperperiod;/**< lcm of all pair periods in ns */
+    smx_tf_slot_t*      slots;      /**< the dispatch table */
+    int                 slot_count; /**< number of dispatch table entries */
+    int                 slot;       /**< the next entry to dispatch */
+    uint64_t            cycle;      /**< the current hyperperiod */
+    uint64_t            epoch;      /**< start of the first hyperperiod */
+    uint64_t            phase;      /**< offset from the common tf epoch */
+    bool                use_wheel;  /**< ticks come from the timer wheel */
+    smx_timer_entry_t   tick;       /**< the periodic timer of the wheel */
+    uint64_t            ticks;      /**< number of expired periods */
+    uint64_t            seen;       /**< number of consumed periods */
+    pthread_mutex_t     mutex;      /**< protects the tick counters */
+    pthread_cond_t      cv;         /**< signals a tick */
+    smx_tf_stats_t      stats;      /**< the timing statistics */
+    bool*               is_handoff; /**< pairs propagated by a handoff */
+};
+
+/**
+ * @brief A propagation shard of a temporal firewall
+ *
+ * The due port pairs of an instant are distributed round-robin over the
+ * shards. Shard 0 is propagated by the thread of the temporal firewall, all
+ * other shards by a worker thread each.
+ */
+struct smx_tf_shard_s
+{
+    int                 id;         /**< the index of the shard */
+    smx_net_t*          net;        /**< the temporal firewall */
+    net_smx_tf_state_t* state;      /**< the state of the temporal firewall */
+    pthread_t           thread;     /**< the worker thread */
+    smx_hist_t          propagation;/**< the propagation time in ns */
 };
 
 /**
@@ -48,6 +111,14 @@ struct smx_timer_s
 struct net_smx_tf_state_s
 {
     bool do_copy;    /**< config argument to indicate whether msgs are copied */
+    int shard_count; /**< config argument for the number of shards */
+    smx_tf_shard_t* shards;     /**< the propagation shards */
+    bool is_running;            /**< false once the workers must terminate */
+    uint64_t generation;        /**< number of released instants */
+    int pending;                /**< number of workers still propagating */
+    pthread_mutex_t mutex;      /**< protects the shard synchronisation */
+    pthread_cond_t release_cv;  /**< releases the workers */
+    pthread_cond_t join_cv;     /**< signals the last finished worker */
 };
 
 /**
@@ -60,6 +131,25 @@ struct net_smx_tf_state_s
 void smx_connect_tf( smx_net_t* net, smx_channel_t* ch_in,
         smx_channel_t* ch_out );
 
+/**
+ * @brief connect a port pair with its own rate to a temporal firewall
+ *
+ * The messages of the pair are propagated every period, starting at the phase
+ * offset. The firewall computes the hyperperiod of all pairs and only wakes up
+ * at instants where at least one pair is due.
+ *
+ * @param net       pointer to the timer net handler
+ * @param ch_in     input channel to the temporal firewall
+ * @param ch_out    output channel from the temporal firewall
+ * @param sec       propagation period in seconds
+ * @param nsec      propagation period in nano seconds
+ * @param phase_sec     phase offset in seconds
+ * @param phase_nsec    phase offset in nano seconds
+ */
+void smx_connect_tf_rate( smx_net_t* net, smx_channel_t* ch_in,
+        smx_channel_t* ch_out, int sec, int nsec, int phase_sec,
+        int phase_nsec );
+
 /**
  * @brief create a periodic timer structure
  *
@@ -77,12 +167,42 @@ smx_timer_t* smx_net_create_tf( int sec, int nsec);
 void smx_net_destroy_tf( smx_net_t* net );
 
 /**
- * Allocate net ports and assign connected tf ports to the net ports
+ * Allocate net ports and assign connected tf ports to the net ports. This also
+ * computes the hyperperiod and the dispatch table of the port pairs and reads
+ * the phase offset of the firewall (config arguments `phase_sec` and
+ * `phase_nsec`) relative to the common epoch of all temporal firewalls.
  *
  * @param net   pointer to the temporal firewall
  */
 void smx_net_finalize_tf( smx_net_t* net );
 
+/**
+ * Get the timing statistics of a temporal firewall. The counters are updated
+ * by the thread of the temporal firewall without locking, hence, a concurrent
+ * read may be off by one instant.
+ *
+ * @param net   pointer to the temporal firewall
+ * @return      a pointer to the statistics or NULL if the tf is not initialised
+ */
+smx_tf_stats_t* smx_net_get_tf_stats( smx_net_t* net );
+
+/**
+ * Compute the end-to-end latency bound of a port pair. The bound covers the
+ * chain of temporal firewalls upstream of the pair, where two firewalls are
+ * chained if the consumer of an output of the first firewall produces an
+ * input of the second. The bound of one stage is the longest time from an
+ * instant of the upstream pair to the next instant of the downstream pair,
+ * given the common epoch and the phase offsets of both firewalls.
+ *
+ * @param net       pointer to the temporal firewall
+ * @param pair      the port index of the pair
+ * @param stages    pointer to store the number of chained firewalls, may be
+ *                  NULL
+ * @return          the latency bound in ns from the propagation at the first
+ *                  firewall of the chain to the propagation of the pair
+ */
+uint64_t smx_tf_get_latency_bound( smx_net_t* net, int pair, int* stages );
+
 /**
  * @brief init a timer structure and the list of temporal firewalls inside
  *
@@ -93,26 +213,51 @@ void smx_net_finalize_tf( smx_net_t* net );
 void smx_net_init_tf( smx_net_t* net, int sec, int nsec );
 
 /**
- * @brief enable periodic tt timer
+ * @brief start the dispatch schedule of the temporal firewall
+ *
+ * The first temporal firewall to dispatch sets the common epoch. All
+ * firewalls start their dispatch schedule with their first dispatch at the
+ * first hyperperiod boundary of the common epoch shifted by their phase offset
+ * which is not in the past. This selects the port pairs which are propagated
+ * by a handoff and logs the end-to-end latency bounds of chained port pairs.
  *
  * @param h     the net handler
  */
 void smx_tf_enable( smx_net_t* h );
 
 /**
- * Read all input channels of a temporal firewall and propagate the messages to
- * the corresponding outputs of the temporal firewall.
+ * Read all input channels of the port pairs which are due at the current
+ * instant of the dispatch table and propagate the messages to the
+ * corresponding outputs of the temporal firewall. If messages are not copied,
+ * pairs with a handoff capable output move the message into the output D_FIFO
+ * with smx_channel_handoff().
  *
  * @param h     pointer to the net handler
  * @param copy   1 if messages ought to be duplicated, 0 otherwise
  */
 void smx_tf_propagate_msgs( smx_net_t* h, int copy );
 
+/**
+ * Propagate the messages of one shard of the port pairs which are due at the
+ * current instant of the dispatch table. The due pairs are assigned
+ * round-robin, i.e. pair j belongs to shard j % shard_count.
+ *
+ * @param h             pointer to the net handler
+ * @param copy          1 if messages ought to be duplicated, 0 otherwise
+ * @param shard         the index of the shard to propagate
+ * @param shard_count   the number of shards
+ */
+void smx_tf_propagate_shard( smx_net_t* h, int copy, int shard,
+        int shard_count );
+
 /**
  * @brief blocking wait on timer
  *
- * Waits on the specified time interval. An error message is printed if the
- * deadline was missed.
+ * Waits until the current instant of the dispatch table. If the instant was
+ * missed, all further instants which are already due are skipped such that
+ * only the latest one is dispatched, a message is printed, and the miss
+ * counter is incremented by the number of missed instants. The wake-up
+ * lateness is recorded in the statistics of the temporal firewall.
  *
  * @param h     the net handler
  */
@@ -131,7 +276,9 @@ void smx_tf_wait( smx_net_t* h );
 int smx_tf( void* h, void* state );
 
 /**
- * Initialises the temporal firewall.
+ * Initialises the temporal firewall. If the config argument `shards` is
+ * larger than one, the port pairs are propagated by as many shards in
+ * parallel. The worker threads inherit the real-time priority of the net.
  *
  * @param h     pointer to the net handler
  * @param state pointer to the state structure
@@ -140,7 +287,8 @@ int smx_tf( void* h, void* state );
 int smx_tf_init( void* h, void** state );
 
 /**
- * Cleanup the temporal firewall by freeing the state structure.
+ * Cleanup the temporal firewall by stopping the shard workers, logging the
+ * timing statistics and freeing the state structure.
  *
  * @param h     pointer to the net handler
  * @param state pointer to the state structure
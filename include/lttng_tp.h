@@ -359,6 +359,54 @@ TRACEPOINT_EVENT_INSTANCE(
     )
 )
 
+TRACEPOINT_EVENT_CLASS(
+    smx_lttng,
+    smx_tf,
+    TP_ARGS(
+        int, id_net,
+        const char*, name_net,
+        uint64_t, val
+    ),
+    TP_FIELDS(
+        ctf_integer(int, id_net, id_net)
+        ctf_string(name_net, name_net)
+        ctf_integer(uint64_t, val, val)
+    )
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+    smx_lttng,
+    smx_tf,
+    tf_wakeup,
+    TP_ARGS(
+        int, id_net,
+        const char*, name_net,
+        uint64_t, val
+    )
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+    smx_lttng,
+    smx_tf,
+    tf_miss,
+    TP_ARGS(
+        int, id_net,
+        const char*, name_net,
+        uint64_t, val
+    )
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+    smx_lttng,
+    smx_tf,
+    tf_propagate,
+    TP_ARGS(
+        int, id_net,
+        const char*, name_net,
+        uint64_t, val
+    )
+)
+
 #endif /* _LTTNG_TP */
 
 #include <lttng/tracepoint-event.h>
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @file    smxce.h
+ * @author  Simon Maurer
+ *
+ * The cyclic executive of the runtime system library of Streamix. Small
+ * time-triggered workloads can be executed by one executive thread per core
+ * instead of one thread per net. A net joins the executive of a core with the
+ * net properties `cyclic_executive` and `ce_core`. Its period is given by the
+ * `expected_rate` and its budget by the `wcet` property (in microseconds).
+ *
+ * The executive builds a static table of all releases within the hyperperiod
+ * of its nets and executes the box implementations in release order. All
+ * ports of a net in an executive must be decoupled such that no access ever
+ * blocks the executive. The net threads only initialise and clean up their
+ * net and are blocked while the executive runs the net.
+ */
+
+#include "smxtypes.h"
+
+#ifndef SMXCE_H
+#define SMXCE_H
+
+/**
+ * Get the cyclic executive of a core and assign a net to it. The executive is
+ * created on demand. A net cannot be assigned to an executive which is
+ * already running because its schedule table is static.
+ *
+ * @param rts   a pointer to the RTS structure
+ * @param core  the core the executive is pinned to
+ * @return      a pointer to the executive or NULL on failure or if the
+ *              executive is already running
+ */
+smx_ce_t* smx_ce_assign( smx_rts_t* rts, int core );
+
+/**
+ * Check whether a net can be executed by a cyclic executive, i.e. whether all
+ * its ports are decoupled on its side and it has no source channels.
+ *
+ * @param net   a pointer to the net
+ * @return      true if the net qualifies, false otherwise
+ */
+bool smx_ce_is_capable( smx_net_t* net );
+
+/**
+ * Destroy all cyclic executives. This must be called once all nets have
+ * terminated.
+ *
+ * @param rts   a pointer to the RTS structure
+ */
+void smx_ce_destroy( smx_rts_t* rts );
+
+/**
+ * Hand the loop of a net over to its cyclic executive and block until the
+ * executive has terminated the net. The executive is started once all
+ * assigned nets joined or left.
+ *
+ * @param ce    a pointer to the cyclic executive
+ * @param net   a pointer to the net
+ * @param impl  the box implementation of the net
+ * @return      0 on success, -1 on failure in which case the net must execute
+ *              its loop itself
+ */
+int smx_ce_join( smx_ce_t* ce, smx_net_t* net, int impl( void*, void* ) );
+
+/**
+ * Withdraw a net from its cyclic executive without executing it, e.g. if the
+ * initialisation of the net failed. This has no effect if the net already
+ * joined the executive.
+ *
+ * @param ce    a pointer to the cyclic executive
+ * @param net   a pointer to the net
+ */
+void smx_ce_leave( smx_ce_t* ce, smx_net_t* net );
+
+#endif /* SMXCE_H */
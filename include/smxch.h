@@ -285,6 +285,17 @@
  */
 int smx_channel_await( void *h, smx_channel_t* ch );
 
+/**
+ * Wait for a channel trigger like smx_channel_await() but also return with 0
+ * once topology or live configuration updates are pending for the net such that
+ * the net loop can apply them.
+ *
+ * @param h     pointer to the net handler
+ * @param ch    pointer to the channel
+ * @return      0 on success, channel error on failure.
+ */
+int smx_channel_await_update( void *h, smx_channel_t* ch );
+
 /**
  * Read data from the channel. The function blocks as long as no data is
  * available in the channel. See smx_channel_await() for more information.
@@ -488,6 +499,33 @@ void smx_channel_terminate_source( smx_channel_t* ch );
 int smx_channel_write( void* h, smx_channel_t* ch, smx_msg_t* msg );
 int smx_channel_write_rts( void* h, smx_channel_t* ch, smx_msg_t* msg );
 
+/**
+ * @brief Hand a message over to an input-decoupled channel
+ *
+ * This is the propagation path of the temporal firewall. The ownership of the
+ * message is moved into the D_FIFO of the channel without blocking and
+ * without the filter, guard and collector logic of smx_channel_write(). If
+ * the D_FIFO is full the latest-value slot is swapped and the displaced
+ * message is destroyed after the channel is unlocked. Use
+ * smx_channel_is_handoff_capable() to check whether a channel qualifies.
+ *
+ * @param h     pointer to the net handler
+ * @param ch    pointer to the channel
+ * @param msg   pointer to the a message structure
+ * @return      0 on success, -1 if the consumer has terminated
+ */
+int smx_channel_handoff( void* h, smx_channel_t* ch, smx_msg_t* msg );
+
+/**
+ * Check whether smx_channel_handoff() preserves the semantics of
+ * smx_channel_write() on a channel, i.e. whether the channel is decoupled at
+ * the input and has no type filter, content filter, guard, or collector.
+ *
+ * @param ch    pointer to the channel
+ * @return      true if the channel qualifies for a handoff, false otherwise
+ */
+bool smx_channel_is_handoff_capable( smx_channel_t* ch );
+
 /**
  * Create a collector structure and initialize it.
  *
@@ -696,6 +734,15 @@ smx_guard_t* smx_guard_create( int iats, int iatns, smx_channel_t* ch );
  */
 void smx_guard_destroy( smx_guard_t* guard );
 
+/**
+ * @brief mark the minimal inter-arrival time of a guard as passed
+ *
+ * This is the timer callback of a guard and is called by the timer thread.
+ *
+ * @param arg   pointer to the guard structure
+ */
+void smx_guard_expire( void* arg );
+
 /**
  * @brief imposes a rate-controld on write operations
  *
@@ -435,6 +435,124 @@ int smx_config_init_int( bson_t* conf, const char* search, int* val );
  */
 bool smx_config_is_format_string(const char* s, bson_type_t type );
 
+/**
+ * Create the net property index of an app configuration. The index refers to
+ * the data of the configuration which must outlive the index.
+ *
+ * @param conf
+ *  The app configuration holding the mandatory `_nets` document.
+ * @return
+ *  A pointer to the index or NULL on failure.
+ */
+smx_net_props_t* smx_config_net_props_create( bson_t* conf );
+
+/**
+ * Destroy the net property index.
+ *
+ * @param props
+ *  A pointer to the index to destroy.
+ */
+void smx_config_net_props_destroy( smx_net_props_t* props );
+
+/**
+ * Get a net configuration file which was loaded with
+ * smx_config_net_props_load_files(). The document is shared by all nets and
+ * must be treated as read-only.
+ *
+ * @param props
+ *  A pointer to the property index.
+ * @param path
+ *  The path of the configuration file.
+ * @param file
+ *  A pointer which is set to the file entry. The document of the entry is
+ *  NULL if the file could not be parsed.
+ * @return
+ *  true if the file is cached, false if it has to be loaded by the caller.
+ */
+bool smx_config_net_props_get_file( smx_net_props_t* props, const char* path,
+        smx_config_file_t** file );
+
+/**
+ * Find a net property of a given type. The search starts at the given node
+ * and falls back to the less specific levels until a property with a matching
+ * name and type is found.
+ *
+ * @param props
+ *  A pointer to the property index.
+ * @param node
+ *  The most specific level to start the search, as returned by
+ *  smx_config_net_props_lookup().
+ * @param prop
+ *  The name of the property.
+ * @param type
+ *  The required BSON type of the property.
+ * @param iter
+ *  An iterator which points to the property on success.
+ * @return
+ *  true if the property was found, false otherwise.
+ */
+bool smx_config_net_props_find( smx_net_props_t* props,
+        smx_net_props_node_t* node, const char* prop, bson_type_t type,
+        bson_iter_t* iter );
+
+/**
+ * Get a boolean net property. Refer to smx_config_net_props_find().
+ *
+ * @return
+ *  the property or false if the property does not exist.
+ */
+bool smx_config_net_props_get_bool( smx_net_props_t* props,
+        smx_net_props_node_t* node, const char* prop );
+
+/**
+ * Get an integer net property. Refer to smx_config_net_props_find().
+ *
+ * @return
+ *  the property or 0 if the property does not exist.
+ */
+int smx_config_net_props_get_int( smx_net_props_t* props,
+        smx_net_props_node_t* node, const char* prop );
+
+/**
+ * Get a string net property. Refer to smx_config_net_props_find().
+ *
+ * @return
+ *  the property or NULL if the property does not exist.
+ */
+const char* smx_config_net_props_get_string( smx_net_props_t* props,
+        smx_net_props_node_t* node, const char* prop );
+
+/**
+ * Parse all net configuration files referred to by a `config` path string in
+ * the property index. Each distinct file is parsed once and files are parsed
+ * in parallel by a pool of worker threads.
+ *
+ * @param props
+ *  A pointer to the property index.
+ * @param thread_cnt
+ *  The maximal number of worker threads.
+ * @return
+ *  0 on success, -1 on failure. A file which fails to parse is not an error.
+ */
+int smx_config_net_props_load_files( smx_net_props_t* props, int thread_cnt );
+
+/**
+ * Get the most specific level of the net property index which matches a net.
+ *
+ * @param props
+ *  A pointer to the property index.
+ * @param impl
+ *  The box implementation name of the net.
+ * @param name
+ *  The name of the net.
+ * @param id
+ *  The id of the net.
+ * @return
+ *  A pointer to the matching node or NULL if the index is empty.
+ */
+smx_net_props_node_t* smx_config_net_props_lookup( smx_net_props_t* props,
+        const char* impl, const char* name, unsigned int id );
+
 /**
  * Check if a given format specifier corresponds to a BSON type.
  *
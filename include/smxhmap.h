@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @file    smxhmap.h
+ * @author  Simon Maurer
+ *
+ * A string-keyed hash map for the runtime system library of Streamix
+ */
+
+#include "smxtypes.h"
+
+#ifndef SMXHMAP_H
+#define SMXHMAP_H
+
+/**
+ * Create a hash map.
+ *
+ * @param size  the initial number of buckets (is rounded up to a power of 2)
+ * @return      a pointer to the created map or NULL on failure
+ */
+smx_hmap_t* smx_hmap_create( unsigned int size );
+
+/**
+ * Destroy a hash map.
+ *
+ * @param map       a pointer to the map to destroy
+ * @param cleanup   an optional function to free the values of the map
+ */
+void smx_hmap_destroy( smx_hmap_t* map, void ( *cleanup )( void* ) );
+
+/**
+ * Call a function for each item of a hash map. The map must not be modified
+ * during the iteration.
+ *
+ * @param map   a pointer to the map
+ * @param fn    the function to call with the key, the value, and `arg`
+ * @param arg   an argument which is passed to each call
+ */
+void smx_hmap_foreach( smx_hmap_t* map,
+        void ( *fn )( const char*, void*, void* ), void* arg );
+
+/**
+ * Get a value from a hash map.
+ *
+ * @param map   a pointer to the map
+ * @param key   the key of the value
+ * @return      the value or NULL if the key does not exist
+ */
+void* smx_hmap_get( smx_hmap_t* map, const char* key );
+
+/**
+ * Compute the 64 bit FNV-1a hash of a byte sequence.
+ *
+ * @param data  a pointer to the data to hash
+ * @param len   the number of bytes to hash
+ * @return      the hash value
+ */
+uint64_t smx_hmap_hash( const void* data, size_t len );
+
+/**
+ * Insert a value into a hash map. The key is copied.
+ *
+ * @param map   a pointer to the map
+ * @param key   the key of the value
+ * @param val   the value to insert
+ * @return      0 on success, -1 if the key exists or on failure
+ */
+int smx_hmap_put( smx_hmap_t* map, const char* key, void* val );
+
+#endif /* SMXHMAP_H */
@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @file    smxio.h
+ * @author  Simon Maurer
+ *
+ * The I/O service of the runtime system library of Streamix. A single thread
+ * multiplexes the file descriptor sources of all nets with epoll and pushes
+ * the produced messages into the source channels of the nets. Use
+ * smx_net_source_add_fd() to register a file descriptor.
+ */
+
+#include "smxtypes.h"
+
+#ifndef SMXIO_H
+#define SMXIO_H
+
+/**
+ * Register a file descriptor with the I/O service. The descriptor is armed
+ * one-shot and re-armed after each callback such that the callback of a
+ * source never runs concurrently with itself.
+ *
+ * @param io        a pointer to the I/O service
+ * @param net       a pointer to the net owning the source channel
+ * @param idx       the index of the source channel of the net
+ * @param fd        the file descriptor to wait for
+ * @param events    the epoll events to wait for (e.g. EPOLLIN)
+ * @param callback  the callback producing a message on readiness
+ * @return          0 on success, -1 on failure
+ */
+int smx_io_add( smx_io_t* io, smx_net_t* net, int idx, int fd,
+        uint32_t events, smx_source_fd_callback_t callback );
+
+/**
+ * Create the I/O service and start the I/O thread.
+ *
+ * @return  a pointer to the I/O service or NULL on failure
+ */
+smx_io_t* smx_io_create();
+
+/**
+ * Stop the I/O thread and free the I/O service. This must be called once all
+ * nets with fd sources were destroyed.
+ *
+ * @param io    a pointer to the I/O service, may be NULL
+ */
+void smx_io_destroy( smx_io_t* io );
+
+/**
+ * Remove all file descriptors of a net from the I/O service. Once this
+ * returns no callback of the net is running and the I/O thread no longer
+ * writes to the source channels of the net.
+ *
+ * @param io    a pointer to the I/O service, may be NULL
+ * @param net   a pointer to the net
+ */
+void smx_io_remove_net( smx_io_t* io, smx_net_t* net );
+
+#endif /* SMXIO_H */
@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @file    smxmem.h
+ * @author  Simon Maurer
+ *
+ * The real-time memory mode of the runtime system library of Streamix. The
+ * mode is configured in the `_rt_memory` section of the application
+ * configuration:
+ *
+ *  - `lock`: lock all current and future pages of the process into RAM
+ *  - `stack_size`: the stack size of net threads in KiB. The stacks of
+ *    real-time nets are prefaulted when the net thread starts.
+ *  - `msg_reserve`: the heap memory in KiB which is touched at startup and
+ *    kept by the allocator to serve messages without page faults.
+ */
+
+#include "smxtypes.h"
+
+#ifndef SMXMEM_H
+#define SMXMEM_H
+
+/**
+ * Read the `_rt_memory` configuration, configure the allocator, lock the
+ * memory of the process and touch the message reserve. This must be called
+ * before any net thread is started.
+ *
+ * @param rts   a pointer to the RTS structure holding the configuration
+ * @return      0 on success or if the mode is disabled, -1 on failure
+ */
+int smx_mem_init( smx_rts_t* rts );
+
+/**
+ * Get the page fault counters of the calling thread.
+ *
+ * @param minflt    a pointer to store the number of minor page faults
+ * @param majflt    a pointer to store the number of major page faults
+ * @return          0 on success, -1 on failure
+ */
+int smx_mem_get_faults( long* minflt, long* majflt );
+
+/**
+ * Touch the stack of the calling thread such that later growth of the stack
+ * does not cause page faults.
+ *
+ * @param size  the number of bytes to touch
+ */
+void smx_mem_prefault_stack( size_t size );
+
+#endif /* SMXMEM_H */
@@ -43,7 +43,13 @@
 /**
  * @def SMX_NET_GET_CONF()
  *
- * Get the net configuration structure.
+ * Get the net configuration structure. If the net property `dyn_conf_live` is
+ * set, the configuration may be replaced between two loop iterations of the
+ * net. A net waiting for input is woken up to apply a new configuration, such
+ * that an update takes effect at the latest once the running call of the box
+ * implementation returned and, with rate pacing, the next release is reached.
+ * The returned pointer remains valid until the box implementation function
+ * returns and must not be kept across loop iterations.
  *
  * @param h
  *  The pointer to the net handler.
@@ -53,6 +59,21 @@
 #define SMX_NET_GET_CONF( h )\
     ( ( h == NULL ) ? NULL : ( ( smx_net_t* )h )->conf )
 
+/**
+ * @def SMX_NET_GET_CONF_VERSION()
+ *
+ * Get the number of live configuration updates a net received since its
+ * initialisation. This allows a box to detect a configuration change.
+ *
+ * @param h
+ *  The pointer to the net handler.
+ * @return
+ *  The configuration version, 0 for the initial configuration.
+ */
+#define SMX_NET_GET_CONF_VERSION( h )\
+    ( ( h == NULL ) ? 0 : __atomic_load_n( &( ( smx_net_t* )h )->conf_version,\
+        __ATOMIC_ACQUIRE ) )
+
 /**
  * @def SMX_NET_GET_ARGUMENTS()
  *
@@ -170,6 +191,27 @@
     ( ( h == NULL ) ? 0 : ( ( ( smx_net_t* )h )->count == 1 ? 1 : 0 ) )
 
 
+/**
+ * Apply all queued topology updates of a net. This must only be called by the
+ * thread of the net.
+ *
+ * @param h
+ *  A pointer to the net handler.
+ * @return
+ *  SMX_NET_END if the net was asked to stop, SMX_NET_CONTINUE otherwise.
+ */
+int smx_net_apply_updates( smx_net_t* h );
+
+/**
+ * Check whether topology or live configuration updates are pending for a net.
+ *
+ * @param h
+ *  A pointer to the net handler.
+ * @return
+ *  true if the net loop has updates to apply, false otherwise.
+ */
+bool smx_net_has_updates( smx_net_t* h );
+
 /**
  * Read from a collector of a net.
  *
@@ -183,6 +225,29 @@
 smx_msg_t* smx_net_collector_read( void* h, smx_collector_t* collector,
         smx_channel_t** in, int count_in, int* last_idx );
 
+/**
+ * Listen on the dynamic configuration port of a net and hand each new
+ * configuration over to the net. The net is woken up if it waits for input and
+ * swaps the configuration before its next call of the box implementation (see
+ * smx_net_apply_conf()) such that no reader holds a reference to the previous
+ * configuration when it is freed. This is the start routine of the
+ * configuration listener thread and returns once the port is closed.
+ *
+ * @param arg
+ *  A pointer to the net handler.
+ * @return
+ *  NULL
+ */
+void* smx_net_conf_listen( void* arg );
+
+/**
+ * Apply a pending live configuration update. This must only be called by the
+ * net thread between two calls of the box implementation.
+ *
+ * @param h     a pointer to the net handler
+ */
+void smx_net_apply_conf( smx_net_t* h );
+
 /**
  * Create a new net instance. This includes
  *  - creating a zlog category
@@ -200,6 +265,45 @@ smx_msg_t* smx_net_collector_read( void* h, smx_collector_t* collector,
 smx_net_t* smx_net_create( unsigned int id, const char* name,
         const char* impl, const char* cat_name, smx_rts_t* rts, int prio );
 
+/**
+ * Create the rate pacer of a net. Pacing requires a positive `expected_rate`
+ * property.
+ *
+ * @param h         pointer to the net handler
+ * @param policy    the pacing policy: "none", "catch_up", or "skip". If NULL
+ *                  no pacer is created.
+ * @return          a pointer to the pacer or NULL if pacing is disabled
+ */
+smx_net_pacer_t* smx_net_create_pacer( smx_net_t* h, const char* policy );
+
+/**
+ * Create the SCHED_DEADLINE parameters of a time-triggered net. The deadline
+ * mode is opt-in and is enabled by a positive `dl_runtime` property. It is
+ * only available for nets with a real-time priority.
+ *
+ * @param h         pointer to the net handler
+ * @param runtime   the reserved runtime per period in microseconds
+ * @param deadline  the relative deadline in microseconds. If 0 the period is
+ *                  used.
+ * @param period    the release period in microseconds
+ * @return          a pointer to the parameters or NULL if the deadline mode is
+ *                  disabled or the parameters are invalid
+ */
+smx_net_sched_dl_t* smx_net_create_sched_dl( smx_net_t* h, int runtime,
+        int deadline, int period );
+
+/**
+ * Switch the calling net thread to SCHED_DEADLINE. If the kernel refuses the
+ * policy (e.g. due to missing privileges or admission control) the thread
+ * keeps its SCHED_FIFO priority. In both cases the net loop is released with
+ * the deadline period at absolute deadlines. Temporal firewalls are released
+ * by their dispatch table instead.
+ *
+ * @param h         pointer to the net handler
+ * @return          0 if SCHED_DEADLINE is active, -1 otherwise
+ */
+int smx_net_set_sched_dl( smx_net_t* h );
+
 /**
  * Destroy a net
  *
@@ -265,6 +369,21 @@ bool smx_net_get_boolean_prop( bson_t* conf, const char* name, const char* impl,
 int smx_net_get_int_prop( bson_t* conf, const char* name, const char* impl,
         unsigned int id, const char* prop );
 
+/**
+ * Get the loop timing statistics of a net. The statistics hold histograms of
+ * the time spent waiting for input triggers, the time spent in the box
+ * implementation, and the total loop time. Use smx_hist_get_percentile() to
+ * query percentiles. The statistics are updated by the net thread without
+ * locking such that a concurrent reader may observe a slightly inconsistent
+ * snapshot.
+ *
+ * @param h
+ *  pointer to the net handler
+ * @return
+ *  a pointer to the statistics structure or NULL on failure.
+ */
+smx_net_stats_t* smx_net_get_stats( smx_net_t* h );
+
 /**
  * Get the appropriate json configuration for the current net.
  *
@@ -294,6 +413,22 @@ int smx_net_get_int_prop( bson_t* conf, const char* name, const char* impl,
 int smx_net_get_json_doc( smx_net_t* h, bson_t* conf, const char* name,
         const char* impl, unsigned int id );
 
+/**
+ * Get the json configuration of a net from the net property index. The most
+ * specific `config` item which can be loaded is used.
+ *
+ * @param h
+ *  pointer to the net handler
+ * @param props
+ *  A pointer to the net property index
+ * @param node
+ *  The most specific property level of the net
+ * @return
+ *  0 on success, -1 if nothing was found.
+ */
+int smx_net_get_json_doc_props( smx_net_t* h, smx_net_props_t* props,
+        smx_net_props_node_t* node );
+
 /**
  * Get the json configuration for a given search string.
  *
@@ -347,6 +482,52 @@ const char* smx_net_get_string_prop( bson_t* conf, const char* name, const char*
  */
 void smx_net_init( smx_net_t* h, int indegree, int outdegree );
 
+/**
+ * Load the json configuration of a net from a config item. The item is either
+ * a document or the path to a json file.
+ *
+ * @param h
+ *  pointer to the net handler
+ * @param item
+ *  An iterator pointing to the config item.
+ * @param path
+ *  The config path of the item, used for logging.
+ * @return
+ *  0 on success, -1 if nothing could be loaded.
+ */
+int smx_net_load_conf( smx_net_t* h, bson_iter_t* item, const char* path );
+
+/**
+ * Block until the next release of a rate-paced net. The release times are
+ * absolute deadlines such that the loop rate does not drift. If a release was
+ * missed by at least one period the net either runs back-to-back until it
+ * caught up (`catch_up`) or skips to the next future release (`skip`).
+ *
+ * @param h
+ *  A pointer to the net handler.
+ */
+void smx_net_pace( smx_net_t* h );
+
+/**
+ * Queue a topology update for a net. If the net was not started yet the update
+ * is applied immediately, otherwise the net applies it before its next loop
+ * iteration. Updates for a net which already stopped are rejected. The caller
+ * must hold the RTS net mutex.
+ *
+ * @param h
+ *  A pointer to the net handler.
+ * @param action
+ *  The topology change.
+ * @param ch
+ *  The channel to (dis)connect or NULL for SMX_NET_UPDATE_STOP.
+ * @param terminate
+ *  If true, a removed output channel is marked as terminated.
+ * @return
+ *  0 on success, -1 on failure or if the net is stopped.
+ */
+int smx_net_queue_update( smx_net_t* h, smx_net_update_action_t action,
+        smx_channel_t* ch, bool terminate );
+
 /**
  * Logs a warning if the net rate is lower or higher that the expected net rate
  * by 20%.
@@ -368,6 +549,15 @@ void smx_net_report_rate_warning( smx_net_t* h );
  */
 int smx_net_run( pthread_t* ths, int idx, void* box_impl( void* arg ), void* h );
 
+/**
+ * Mark the initialisation of a net as finished, successful or not, and wake
+ * up all nets waiting for it in smx_net_wait_ready().
+ *
+ * @param h
+ *  A pointer to the net handler.
+ */
+void smx_net_signal_ready( smx_net_t* h );
+
 /**
  * Add a source queue to the net.
  *
@@ -385,6 +575,36 @@ int smx_net_run( pthread_t* ths, int idx, void* box_impl( void* arg ), void* h )
 int smx_net_source_add( smx_net_t* net, int len, struct timespec* timeout,
         int* idx );
 
+/**
+ * Add a source queue to the net which is fed from a file descriptor. The I/O
+ * thread of the RTS waits for the events on the descriptor and calls the
+ * callback once the descriptor is ready. A message returned by the callback is
+ * written to the source queue such that the net loop wakes up exactly when
+ * data is available.
+ *
+ * The callback runs in the I/O thread and must not block. It is never called
+ * concurrently for the same descriptor. If it returns a negative value the
+ * descriptor is removed and the source queue is terminated, i.e. the net
+ * terminates once it has consumed the remaining messages.
+ *
+ * @param net
+ *  A pointer to the net instance.
+ * @param len
+ *  The length of the queue to initialise.
+ * @param fd
+ *  The file descriptor to wait for. It is not closed by the RTS.
+ * @param events
+ *  The epoll events to wait for (e.g. EPOLLIN).
+ * @param callback
+ *  The callback function producing a message from the ready descriptor.
+ * @param idx
+ *  The index of the source new channel.
+ * @return
+ *  0 on success, -1 on failure.
+ */
+int smx_net_source_add_fd( smx_net_t* net, int len, int fd, uint32_t events,
+        smx_source_fd_callback_t callback, int* idx );
+
 /**
  * Disconnect the source channel from the net.
  *
@@ -491,6 +711,15 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
         void cleanup( void*, void* ), int init_shared( void*, void** ),
         void cleanup_shared( void* ), const char* shared_state_key );
 
+/**
+ * Log a summary of the loop timing statistics of a net including percentiles.
+ * This is done periodically if the net property `stats_dump_period` (in
+ * seconds) is set and once on net termination.
+ *
+ * @param h         pointer to the net handler
+ */
+void smx_net_stats_dump( smx_net_t* h );
+
 /**
  * @brief Set all channel states to end and send termination signal to all
  * output channels.
@@ -522,6 +751,20 @@ void smx_net_terminate( smx_net_t* h );
  */
 int smx_net_update_state( smx_net_t* h, int state );
 
+/**
+ * Block until all direct neighbours of a net finished their initialisation.
+ * This replaces a global barrier such that a net starts its loop as soon as
+ * its own subgraph is ready. The producer of the dynamic configuration port is
+ * not waited for and a net does not wait for a consumer which is only
+ * connected through its dynamic configuration port.
+ *
+ * @param h
+ *  A pointer to the net handler.
+ * @param conf_port
+ *  The dynamic configuration port of the net or NULL.
+ */
+void smx_net_wait_ready( smx_net_t* h, smx_channel_t* conf_port );
+
 /**
  * Wait for all nets to terminate by joining the net threads.
  *
@@ -41,4 +41,14 @@ void smx_profiler_log_msg( smx_net_t* net, smx_msg_t* msg,
  */
 void smx_profiler_log_net( smx_net_t* net, smx_profiler_action_net_t action );
 
+/**
+ * The function to log profiler messages related to a temporal firewall.
+ *
+ * @param net       a pointer to the temporal firewall which logs the event.
+ * @param action    the temporal firewall action.
+ * @param val       the wake-up lateness or the propagation time in ns.
+ */
+void smx_profiler_log_tf( smx_net_t* net, smx_profiler_action_tf_t action,
+        uint64_t val );
+
 #endif /* SMXPROFILER_H */
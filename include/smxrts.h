@@ -11,13 +11,20 @@
 #include <zlog.h>
 #include "box_smx_rn.h"
 #include "box_smx_tf.h"
+#include "smxce.h"
 #include "smxch.h"
 #include "smxconfig.h"
+#include "smxhmap.h"
+#include "smxio.h"
 #include "smxlog.h"
+#include "smxmem.h"
 #include "smxmsg.h"
 #include "smxnet.h"
 #include "smxprofiler.h"
+#include "smxstats.h"
+#include "smxsync.h"
 #include "smxtest.h"
+#include "smxtimer.h"
 #include "smxtypes.h"
 #include "smxutils.h"
 
@@ -27,11 +34,14 @@
 // RTS MACROS ------------------------------------------------------------------
 
 /**
- * Macro to create a streamix channel.
+ * Macro to create a streamix channel. The program is aborted if the channel
+ * cannot be created or stored.
  */
-#define SMX_CHANNEL_CREATE( id, len, type, name )\
-    rts->chs[id] = smx_channel_create( &rts->ch_cnt, len, type, id, #name,\
-            STRINGIFY( ch_ ## name ## _ ## id ) )
+#define SMX_CHANNEL_CREATE( id, len, type, name ) do {\
+    if( smx_rts_set_channel( rts, id, smx_channel_create( &rts->ch_cnt, len,\
+                type, id, #name, STRINGIFY( ch_ ## name ## _ ## id ) ) ) < 0 )\
+        smx_program_init_abort( rts );\
+    } while( 0 )
 
 /**
  * Macro to destroy a streamix channel.
@@ -85,11 +95,23 @@
     smx_connect_tf( rts->nets[net_id], rts->chs[ch_in_id], rts->chs[ch_out_id] )
 
 /**
- * Macro to create a streamix net.
+ * Macro to interconnect a temporal firewall with streamix channels where the
+ * port pair has its own period and phase.
  */
-#define SMX_NET_CREATE( id, net_name, box_name, prio )\
-    rts->nets[id] = smx_net_create( id, #net_name, #box_name,\
-            STRINGIFY( net_ ## net_name ## _ ## id ), rts, prio )
+#define SMX_CONNECT_TF_RATE( net_id, ch_in_id, ch_out_id, ch_name, sec, nsec,\
+        phase_sec, phase_nsec )\
+    smx_connect_tf_rate( rts->nets[net_id], rts->chs[ch_in_id],\
+            rts->chs[ch_out_id], sec, nsec, phase_sec, phase_nsec )
+
+/**
+ * Macro to create a streamix net. The program is aborted if the net cannot be
+ * created or stored.
+ */
+#define SMX_NET_CREATE( id, net_name, box_name, prio ) do {\
+    if( smx_rts_set_net( rts, id, smx_net_create( id, #net_name, #box_name,\
+                STRINGIFY( net_ ## net_name ## _ ## id ), rts, prio ) ) < 0 )\
+        smx_program_init_abort( rts );\
+    } while( 0 )
 
 /**
  * Macro to destroy a streamix net.
@@ -155,8 +177,14 @@
     smx_program_init_cleanup( rts )
 
 /**
- * Macro to wait for initialisation of all nets to complete before running the
- * application.
+ * Macro to size the topology tables to the number of nets and channels of the
+ * application. This is optional, the tables grow on demand.
+ */
+#define SMX_PROGRAM_INIT_TOPOLOGY( net_count, ch_count )\
+    smx_program_init_topology( rts, net_count, ch_count )
+
+/**
+ * Macro to prepare running the application. Refer to smx_program_init_run().
  */
 #define SMX_PROGRAM_INIT_RUN()\
     smx_program_init_run( rts )
@@ -186,6 +214,14 @@
  */
 void smx_program_cleanup( smx_rts_t* rts );
 
+/**
+ * Abort the program during initialisation, e.g. if the topology cannot be
+ * created. This closes the log and terminates the process.
+ *
+ * @param rts   a pointer to the RTS structure
+ */
+void smx_program_init_abort( smx_rts_t* rts );
+
 /**
  * Initialize the rts structure, read the configuration files, and initialize
  * the log.
@@ -264,14 +300,279 @@ int smx_program_init_maps( const char* path, bson_t* doc, bson_iter_t* i_maps,
         bson_t* payload );
 
 /**
- * Initialize the synchronisation barrier to make sure all nets finish
- * intialisation befor staring the main loop.
+ * Size the topology tables of the RTS. The tables are only grown, never
+ * shrunk.
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param net_count
+ *  The number of nets of the application.
+ * @param ch_count
+ *  The number of channels of the application.
+ * @return
+ *  0 on success, -1 on failure.
+ */
+int smx_program_init_topology( smx_rts_t* rts, int net_count, int ch_count );
+
+/**
+ * Build and start a topology described by a JSON file instead of the
+ * generated RTS macros. The file holds an array `channels` of objects with
+ * the keys `name`, `len`, `type` (`fifo`, `fifo_d`, `d_fifo` or `d_fifo_d`)
+ * and an optional `guard` object with `iat_sec` and `iat_nsec`, and an array
+ * `nets` of objects with the keys `name`, `impl`, `prio`, `in` and `out`.
+ * `in` and `out` list channel names in port order. A net with the impl
+ * `smx_tf` requires a `tf` object with `sec` and `nsec` and propagates the
+ * n-th input channel to the n-th output channel. The optional array
+ * `tf.rates` assigns the n-th port pair its own period (`sec`, `nsec`) and
+ * phase (`phase_sec`, `phase_nsec`).
+ *
+ * The start routine of a net is the symbol `start_routine_<impl>`, resolved
+ * with `dlsym()` on the handle of `dlopen( NULL )`. The application must
+ * therefore be linked with `-rdynamic`, otherwise every lookup fails.
+ *
+ * The whole file is checked before anything is created: channel names and
+ * types, the start routines, the channel references of the nets and the rates
+ * of temporal firewalls. Then all channels and nets are created and connected
+ * and only then the nets are started. If any of these steps fails, the nets
+ * and channels created so far are stopped, disconnected and destroyed.
+ * Otherwise the nets are joined and destroyed by smx_program_cleanup().
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param path
+ *  The path to the topology file.
+ * @return
+ *  0 on success, -1 on failure.
+ */
+int smx_program_load_topology( smx_rts_t* rts, const char* path );
+
+/**
+ * Log the startup statistics before the nets are started. Nets do not wait
+ * for each other globally: each net starts its main loop as soon as itself and
+ * its direct neighbours are initialised (see smx_net_wait_ready()).
  *
  * @param rts
  *  A pointer to the RTS structure which holds the network information.
  */
 void smx_program_init_run( smx_rts_t* rts );
 
+/**
+ * Store a channel in the channel table of the RTS. The table grows if
+ * necessary.
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param id
+ *  The id of the channel.
+ * @param ch
+ *  A pointer to the channel.
+ * @return
+ *  0 on success, -1 if the channel is NULL or the table cannot grow.
+ */
+int smx_rts_set_channel( smx_rts_t* rts, int id, smx_channel_t* ch );
+
+/**
+ * Store a net in the net table of the RTS. The net and the thread tables grow
+ * if necessary.
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param id
+ *  The id of the net.
+ * @param net
+ *  A pointer to the net.
+ * @return
+ *  0 on success, -1 if the net is NULL or the tables cannot grow.
+ */
+int smx_rts_set_net( smx_rts_t* rts, int id, smx_net_t* net );
+
+/**
+ * Create a streamix channel at runtime. The channel is owned by the RTS and
+ * is destroyed at program cleanup.
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param name
+ *  The name of the channel.
+ * @param len
+ *  The length of the channel FIFO.
+ * @param type
+ *  The type of the channel.
+ * @return
+ *  A pointer to the created channel or NULL on failure.
+ */
+smx_channel_t* smx_rts_channel_create( smx_rts_t* rts, const char* name,
+        int len, smx_channel_type_t type );
+
+/**
+ * Connect a channel to an input port of a net at runtime. The channel end is
+ * claimed atomically and the port is added by the thread of the net at the
+ * top of its next iteration.
+ *
+ * @param net
+ *  A pointer to the net.
+ * @param ch
+ *  A pointer to the channel.
+ * @return
+ *  0 on success, -1 if the channel end is already connected or on failure.
+ */
+int smx_rts_connect_in( smx_net_t* net, smx_channel_t* ch );
+
+/**
+ * Connect a channel to an output port of a net at runtime. The channel end is
+ * claimed atomically and the port is added by the thread of the net at the
+ * top of its next iteration.
+ *
+ * @param net
+ *  A pointer to the net.
+ * @param ch
+ *  A pointer to the channel.
+ * @return
+ *  0 on success, -1 if the channel end is already connected or on failure.
+ */
+int smx_rts_connect_out( smx_net_t* net, smx_channel_t* ch );
+
+/**
+ * Create and initialise a streamix net at runtime. The net is started with
+ * smx_rts_net_start() once its channels are connected.
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param name
+ *  The name of the net.
+ * @param impl
+ *  The name of the box implementation.
+ * @param indegree
+ *  The number of input ports.
+ * @param outdegree
+ *  The number of output ports.
+ * @param prio
+ *  The thread priority of the net.
+ * @return
+ *  A pointer to the created net or NULL on failure.
+ */
+smx_net_t* smx_rts_net_create( smx_rts_t* rts, const char* name,
+        const char* impl, int indegree, int outdegree, int prio );
+
+/**
+ * Wait for a net created at runtime to terminate, disconnect it from its
+ * neighbours and destroy it. Call smx_rts_net_drain() first.
+ *
+ * @param net
+ *  A pointer to the net.
+ * @return
+ *  0 on success, -1 on failure.
+ */
+int smx_rts_net_detach( smx_net_t* net );
+
+/**
+ * Drain a net. The producers of all input channels stop writing to the net
+ * and terminate the channels such that the net processes the remaining
+ * messages and terminates. A net without inputs is stopped directly.
+ *
+ * @param net
+ *  A pointer to the net.
+ * @return
+ *  0 on success, -1 on failure.
+ */
+int smx_rts_net_drain( smx_net_t* net );
+
+/**
+ * Start the thread of a net created at runtime.
+ *
+ * @param net
+ *  A pointer to the net.
+ * @param start_routine
+ *  The start routine of the net.
+ * @return
+ *  0 on success, -1 on failure.
+ */
+int smx_rts_net_start( smx_net_t* net, void* start_routine( void* ) );
+
+/**
+ * Join and destroy all nets and destroy all channels which were created at
+ * runtime.
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ */
+void smx_rts_topology_cleanup( smx_rts_t* rts );
+
+/**
+ * Create an empty shared state registry.
+ *
+ * @return
+ *  A pointer to the registry or NULL on failure.
+ */
+smx_rts_shared_state_registry_t* smx_rts_shared_state_create();
+
+/**
+ * Destroy the shared state registry and free all shared state items with
+ * their cleanup function.
+ *
+ * @param reg
+ *  A pointer to the registry to destroy.
+ */
+void smx_rts_shared_state_destroy( smx_rts_shared_state_registry_t* reg );
+
+/**
+ * Get a shared state item from the registry. The lookup is lock-free and must
+ * be performed by a thread which is registered with RCU (all net threads are).
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param key
+ *  The key of the shared state item.
+ * @return
+ *  The shared state or NULL if no item with the key exists.
+ */
+void* smx_rts_shared_state_get( smx_rts_t* rts, const char* key );
+
+/**
+ * Get a shared state item from the registry or initialise and register it if
+ * it does not exist yet. On a miss the item is initialised without holding the
+ * registry mutex and then added only if the key is still unknown. If nets race
+ * on the same key, the first registered item wins and the state of the others
+ * is passed to the cleanup function. The cleanup function is also called with
+ * the state of a failed init.
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param key
+ *  The key of the shared state item.
+ * @param h
+ *  A pointer to the net handler which is passed to the init function.
+ * @param init
+ *  The function to initialise the shared state.
+ * @param cleanup
+ *  The function to free the shared state at program cleanup.
+ * @param state
+ *  A pointer which is set to the shared state.
+ * @return
+ *  1 if the item already existed, 0 if it was initialised, -1 on failure.
+ */
+int smx_rts_shared_state_get_or_init( smx_rts_t* rts, const char* key,
+        void* h, int init( void*, void** ), void cleanup( void* ),
+        void** state );
+
+/**
+ * Add a shared state item to the registry. This can be used at any time after
+ * the program initialisation.
+ *
+ * @param rts
+ *  A pointer to the RTS structure.
+ * @param key
+ *  The key of the shared state item. The key is copied.
+ * @param state
+ *  The shared state.
+ * @param cleanup
+ *  An optional function to free the shared state at program cleanup.
+ * @return
+ *  0 on success, -1 if the key already exists or on failure.
+ */
+int smx_rts_shared_state_put( smx_rts_t* rts, const char* key, void* state,
+        void cleanup( void* ) );
+
 /**
  * Get the current version of the library.
  *
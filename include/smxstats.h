@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @file    smxstats.h
+ * @author  Simon Maurer
+ *
+ * Latency statistics for the runtime system library of Streamix
+ */
+
+#include <zlog.h>
+#include "smxtypes.h"
+
+#ifndef SMXSTATS_H
+#define SMXSTATS_H
+
+/**
+ * Get the value at a given percentile of a histogram. The returned value is
+ * the upper bound of the bucket holding the percentile which is accurate up to
+ * the histogram resolution.
+ *
+ * @param hist          a pointer to the histogram
+ * @param percentile    the percentile in the range [0, 100]
+ * @return              the value at the percentile in nanoseconds or 0 if the
+ *                      histogram is empty
+ */
+uint64_t smx_hist_get_percentile( smx_hist_t* hist, double percentile );
+
+/**
+ * Get the mean of all recorded values of a histogram.
+ *
+ * @param hist  a pointer to the histogram
+ * @return      the mean value in nanoseconds or 0 if the histogram is empty
+ */
+double smx_hist_get_mean( smx_hist_t* hist );
+
+/**
+ * Initialise (or reset) a histogram.
+ *
+ * @param hist  a pointer to the histogram
+ */
+void smx_hist_init( smx_hist_t* hist );
+
+/**
+ * Log a summary of a histogram including the percentiles p50, p90, p99 and
+ * p99.9.
+ *
+ * @param cat   the zlog category to log to
+ * @param name  the name of the histogram to be printed in the log
+ * @param hist  a pointer to the histogram
+ */
+void smx_hist_log( zlog_category_t* cat, const char* name, smx_hist_t* hist );
+
+/**
+ * Record a value in a histogram.
+ *
+ * @param hist  a pointer to the histogram
+ * @param val   the value to record in nanoseconds
+ */
+void smx_hist_record( smx_hist_t* hist, uint64_t val );
+
+#endif /* SMXSTATS_H */
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @file    smxsync.h
+ * @author  Simon Maurer
+ *
+ * Synchronisation primitives for shared state of the runtime system library
+ * of Streamix.
+ *
+ * The primitives are meant to be created in the `init_shared` handler of a box
+ * and stored in the shared state. They are owned by the RTS: they are freed
+ * after all `cleanup_shared` handlers were executed and their contention
+ * statistics are logged at program cleanup.
+ */
+
+#include "smxtypes.h"
+
+#ifndef SMXSYNC_H
+#define SMXSYNC_H
+
+/**
+ * Create an RCU-protected pointer.
+ *
+ * @param h         a pointer to the net handler
+ * @param name      the name of the pointer, used for logging
+ * @param ptr       the initial pointer, may be NULL
+ * @param cleanup   a function to free a pointer which is no longer published
+ * @return          a pointer to the RCU pointer or NULL on failure
+ */
+smx_rcu_ptr_t* smx_rcu_ptr_create( void* h, const char* name, void* ptr,
+        void cleanup( void* ) );
+
+/**
+ * Publish a new pointer. Readers see either the old or the new pointer. The
+ * call blocks until all readers of the old pointer are done and then frees
+ * the old pointer. Must not be called within a read-side critical section.
+ *
+ * @param rcu_ptr   a pointer to the RCU pointer
+ * @param ptr       the new pointer
+ */
+void smx_rcu_ptr_publish( smx_rcu_ptr_t* rcu_ptr, void* ptr );
+
+/**
+ * Enter a read-side critical section and get the published pointer. The
+ * pointer remains valid until smx_rcu_ptr_read_unlock() is called. This is
+ * wait-free. The calling thread must be registered with RCU (all net threads
+ * are).
+ *
+ * @param rcu_ptr   a pointer to the RCU pointer
+ * @return          the published pointer
+ */
+void* smx_rcu_ptr_read_lock( smx_rcu_ptr_t* rcu_ptr );
+
+/**
+ * Leave a read-side critical section.
+ *
+ * @param rcu_ptr   a pointer to the RCU pointer
+ */
+void smx_rcu_ptr_read_unlock( smx_rcu_ptr_t* rcu_ptr );
+
+/**
+ * Create a seqlock-protected record.
+ *
+ * @param h     a pointer to the net handler
+ * @param name  the name of the record, used for logging
+ * @param size  the size of the record in bytes
+ * @param init  the initial record or NULL to zero the record
+ * @return      a pointer to the seqlock or NULL on failure
+ */
+smx_seqlock_t* smx_seqlock_create( void* h, const char* name, size_t size,
+        const void* init );
+
+/**
+ * Read a consistent copy of a seqlock-protected record. This never blocks a
+ * writer and is retried if the record was written during the copy.
+ *
+ * @param lock  a pointer to the seqlock
+ * @param dst   a pointer to a buffer of the record size
+ */
+void smx_seqlock_read( smx_seqlock_t* lock, void* dst );
+
+/**
+ * Write a seqlock-protected record.
+ *
+ * @param lock  a pointer to the seqlock
+ * @param src   a pointer to the new record
+ */
+void smx_seqlock_write( smx_seqlock_t* lock, const void* src );
+
+/**
+ * Log the contention statistics of and free all seqlocks and RCU pointers of
+ * the RTS.
+ *
+ * @param rts   a pointer to the RTS structure
+ */
+void smx_sync_cleanup( smx_rts_t* rts );
+
+#endif /* SMXSYNC_H */
@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @file    smxtimer.h
+ * @author  Simon Maurer
+ *
+ * A hierarchical timer wheel shared by the guards and the non-RT temporal
+ * firewalls of the runtime system library of Streamix. All timers are served
+ * by a single thread such that no file descriptor or kernel timer is needed
+ * per timer. Timers expire on the first wheel tick after their deadline, i.e.
+ * with a resolution of #SMX_TIMER_WHEEL_TICK_NS.
+ */
+
+#include "smxtypes.h"
+
+#ifndef SMXTIMER_H
+#define SMXTIMER_H
+
+/**
+ * Arm a timer. An armed timer is re-armed with the new deadline. This does not
+ * require a system call. The wheel and its thread are started with the first
+ * timer.
+ *
+ * @param timer     a pointer to a timer initialised with smx_timer_init()
+ * @param deadline  the expiry time in nanoseconds (CLOCK_MONOTONIC)
+ * @param period    the period in nanoseconds or 0 for a one-shot timer. If a
+ *                  periodic timer overruns, missed periods are skipped.
+ * @return          0 on success, -1 on failure
+ */
+int smx_timer_arm( smx_timer_entry_t* timer, uint64_t deadline,
+        uint64_t period );
+
+/**
+ * Cancel a timer. Once this returns the callback of the timer is not running
+ * and will not be called until the timer is armed again.
+ *
+ * @param timer     a pointer to the timer
+ */
+void smx_timer_cancel( smx_timer_entry_t* timer );
+
+/**
+ * Initialise a timer.
+ *
+ * @param timer     a pointer to the timer
+ * @param callback  the function to call on expiry. It is called by the timer
+ *                  thread and must not block.
+ * @param arg       the argument to pass to the callback
+ */
+void smx_timer_init( smx_timer_entry_t* timer, void callback( void* ),
+        void* arg );
+
+/**
+ * Stop the timer thread, log the jitter statistics and free the wheel. This
+ * must be called once all timers were cancelled.
+ */
+void smx_timer_wheel_cleanup();
+
+#endif /* SMXTIMER_H */
@@ -7,6 +7,7 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <zlog.h>
 #include <bson.h>
@@ -30,11 +31,13 @@
 
 /**
  * The number of maximal allowed nets in one streamix application.
+ * @deprecated The topology tables grow dynamically, this is no longer enforced.
  */
 #define SMX_MAX_NETS 1000
 
 /**
  * The number of maximal allowed channel in one streamix application.
+ * @deprecated The topology tables grow dynamically, this is no longer enforced.
  */
 #define SMX_MAX_CHS 10000
 
@@ -43,6 +46,51 @@
  */
 #define SMX_MAX_SOURCE_CHS 10
 
+/**
+ * The resolution of the shared timer wheel in nanoseconds.
+ */
+#define SMX_TIMER_WHEEL_TICK_NS 100000
+
+/**
+ * The number of levels of the shared timer wheel. Each level covers
+ * #SMX_TIMER_WHEEL_SLOTS times the range of the level below.
+ */
+#define SMX_TIMER_WHEEL_LEVELS 4
+
+/**
+ * The number of bits used to index the slots of a timer wheel level.
+ */
+#define SMX_TIMER_WHEEL_SLOT_BITS 8
+
+/**
+ * The number of slots of a timer wheel level.
+ */
+#define SMX_TIMER_WHEEL_SLOTS ( 1 << SMX_TIMER_WHEEL_SLOT_BITS )
+
+/**
+ * The number of bits used for the linear sub-buckets of a histogram. Each
+ * power-of-two range is split into `2^SMX_HIST_SUB_BITS` buckets which limits
+ * the relative recording error to `1/2^SMX_HIST_SUB_BITS`.
+ */
+#define SMX_HIST_SUB_BITS 4
+
+/**
+ * The number of linear sub-buckets per power-of-two range of a histogram.
+ */
+#define SMX_HIST_SUB_COUNT ( 1 << SMX_HIST_SUB_BITS )
+
+/**
+ * The number of bits of the largest value a histogram can record. Larger
+ * values are recorded in the last bucket (2^40ns is about 18 minutes).
+ */
+#define SMX_HIST_MAX_BITS 40
+
+/**
+ * The number of buckets of a histogram.
+ */
+#define SMX_HIST_BUCKET_COUNT\
+    ( ( SMX_HIST_MAX_BITS - SMX_HIST_SUB_BITS + 1 ) * SMX_HIST_SUB_COUNT )
+
 /**
  * The streamix channel error type. Refer to the error enumeration definition
  * for more details #smx_channel_err_e.
@@ -54,19 +102,40 @@ typedef enum smx_channel_type_e smx_channel_type_t;   /**< #smx_channel_type_e *
 typedef enum smx_config_error_e smx_config_error_t;
 /** #smx_config_map_error_e */
 typedef enum smx_config_map_error_e smx_config_map_error_t;
+/** #smx_net_pacing_e */
+typedef enum smx_net_pacing_e smx_net_pacing_t;
+/** #smx_net_update_action_e */
+typedef enum smx_net_update_action_e smx_net_update_action_t;
 /** #smx_profiler_action_e */
 typedef enum smx_profiler_action_ch_e smx_profiler_action_ch_t;
 typedef enum smx_profiler_action_msg_e smx_profiler_action_msg_t;
 typedef enum smx_profiler_action_net_e smx_profiler_action_net_t;
+typedef enum smx_profiler_action_tf_e smx_profiler_action_tf_t;
 
+typedef struct smx_rcu_ptr_s smx_rcu_ptr_t;           /**< ::smx_rcu_ptr_s */
 typedef struct smx_rts_s smx_rts_t; /**< ::smx_rts_s */
 typedef struct smx_rts_shared_state_s smx_rts_shared_state_t; /**< ::smx_rts_shared_state_s */
+/** ::smx_rts_shared_state_node_s */
+typedef struct smx_rts_shared_state_node_s smx_rts_shared_state_node_t;
+/** ::smx_rts_shared_state_table_s */
+typedef struct smx_rts_shared_state_table_s smx_rts_shared_state_table_t;
+/** ::smx_rts_shared_state_registry_s */
+typedef struct smx_rts_shared_state_registry_s smx_rts_shared_state_registry_t;
 typedef struct smx_channel_s smx_channel_t;           /**< ::smx_channel_s */
 typedef struct smx_channel_end_s smx_channel_end_t;   /**< ::smx_channel_end_s */
 typedef struct smx_collector_s smx_collector_t;       /**< ::smx_collector_s */
 typedef struct smx_fifo_s smx_fifo_t;                 /**< ::smx_fifo_s */
 typedef struct smx_fifo_item_s smx_fifo_item_t;       /**< ::smx_fifo_item_s */
 typedef struct smx_guard_s smx_guard_t;               /**< ::smx_guard_s */
+typedef struct smx_hist_s smx_hist_t;                 /**< ::smx_hist_s */
+typedef struct smx_hmap_s smx_hmap_t;                 /**< ::smx_hmap_s */
+typedef struct smx_hmap_item_s smx_hmap_item_t;       /**< ::smx_hmap_item_s */
+typedef struct smx_io_s smx_io_t;                     /**< ::smx_io_s */
+typedef struct smx_io_source_s smx_io_source_t;       /**< ::smx_io_source_s */
+typedef struct smx_ce_s smx_ce_t;                     /**< ::smx_ce_s */
+typedef struct smx_ce_job_s smx_ce_job_t;             /**< ::smx_ce_job_s */
+typedef struct smx_ce_member_s smx_ce_member_t;       /**< ::smx_ce_member_s */
+typedef struct smx_mem_s smx_mem_t;                   /**< ::smx_mem_s */
 /**
  * The streamix message type.
  * Refer to the structure definition for more information ::smx_msg_s.
@@ -74,12 +143,30 @@ typedef struct smx_guard_s smx_guard_t;               /**< ::smx_guard_s */
 typedef struct smx_msg_s smx_msg_t;
 typedef struct smx_net_s smx_net_t;                   /**< ::smx_net_s */
 typedef struct smx_net_sig_s smx_net_sig_t;           /**< ::smx_net_sig_s */
+typedef struct smx_net_pacer_s smx_net_pacer_t;       /**< ::smx_net_pacer_s */
+typedef struct smx_net_sched_dl_s smx_net_sched_dl_t; /**< ::smx_net_sched_dl_s */
+typedef struct smx_net_props_s smx_net_props_t;       /**< ::smx_net_props_s */
+/** ::smx_net_props_node_s */
+typedef struct smx_net_props_node_s smx_net_props_node_t;
+typedef struct smx_net_stats_s smx_net_stats_t;       /**< ::smx_net_stats_s */
+typedef struct smx_net_update_s smx_net_update_t;     /**< ::smx_net_update_s */
+typedef struct smx_seqlock_s smx_seqlock_t;           /**< ::smx_seqlock_s */
+/** ::smx_timer_entry_s */
+typedef struct smx_timer_entry_s smx_timer_entry_t;
+/** ::smx_timer_wheel_s */
+typedef struct smx_timer_wheel_s smx_timer_wheel_t;
 /** ::smx_msg_tsmem_data_map_s */
 typedef struct smx_config_data_map_s smx_config_data_map_t;
+typedef struct smx_config_file_s smx_config_file_t;   /**< ::smx_config_file_s */
+/** ::smx_config_file_job_s */
+typedef struct smx_config_file_job_s smx_config_file_job_t;
 /** ::smx_msg_tsmem_data_maps_s */
 typedef struct smx_config_data_maps_s smx_config_data_maps_t;
 /** The source callback function signature */
 typedef int (*smx_source_callback_t)( smx_net_t* net );
+/** The fd source callback function signature */
+typedef int (*smx_source_fd_callback_t)( smx_net_t* net, int fd,
+        uint32_t events, smx_msg_t** msg );
 /**
  * The error state of a channel end
  */
@@ -152,6 +239,18 @@ enum smx_config_map_error_e
     SMX_CONFIG_MAP_ERROR_BAD_TYPE_OPTION = -291,
 };
 
+/**
+ * The policy of a rate-paced net when a loop release is missed.
+ */
+enum smx_net_pacing_e
+{
+    SMX_NET_PACING_NONE = 0,    /**< the net loop is not paced */
+    /** missed releases are executed back-to-back until the net caught up */
+    SMX_NET_PACING_CATCH_UP,
+    /** missed releases are skipped and the next future release is used */
+    SMX_NET_PACING_SKIP
+};
+
 /**
  * The different actions a profiler can log.
  */
@@ -198,6 +297,28 @@ enum smx_profiler_action_net_e
     SMX_PROFILER_ACTION_NET_SKIP_IMPL,  /**< skip a net implementation. */
 };
 
+/**
+ * The temporal firewall actions to be profiled
+ */
+enum smx_profiler_action_tf_e
+{
+    SMX_PROFILER_ACTION_TF_WAKEUP,      /**< wake up at a dispatch instant. */
+    SMX_PROFILER_ACTION_TF_MISS,        /**< a dispatch instant was missed. */
+    SMX_PROFILER_ACTION_TF_PROPAGATE,   /**< propagation of due pairs done. */
+};
+
+/**
+ * @brief Topology changes of a running net
+ */
+enum smx_net_update_action_e
+{
+    SMX_NET_UPDATE_ADD_IN,      /**< connect an input channel */
+    SMX_NET_UPDATE_ADD_OUT,     /**< connect an output channel */
+    SMX_NET_UPDATE_REMOVE_IN,   /**< disconnect an input channel */
+    SMX_NET_UPDATE_REMOVE_OUT,  /**< disconnect an output channel */
+    SMX_NET_UPDATE_STOP         /**< terminate the net */
+};
+
 /**
  * Constants to indicate wheter a thread should terminate or continue.
  * Use one of these values to return from the main box implemenation funtion.
@@ -339,13 +460,100 @@ struct smx_fifo_item_s
     smx_fifo_item_t* prev;       /**< pointer to the previous item */
 };
 
+/**
+ * @brief A timer of the shared timer wheel
+ *
+ * The entry is embedded in the structure which owns the timer. The callback is
+ * executed by the timer thread with the wheel locked and must not block.
+ */
+struct smx_timer_entry_s
+{
+    uint64_t            deadline;   /**< expiry time in ns (CLOCK_MONOTONIC) */
+    uint64_t            period;     /**< the period in ns, 0 for one-shot */
+    uint64_t            expiry;     /**< the wheel tick of the expiry */
+    unsigned long       missed;     /**< periods skipped due to overruns */
+    bool                is_armed;   /**< true while the timer is queued */
+    void ( *callback )( void* );    /**< called on expiry */
+    void*               arg;        /**< the argument of the callback */
+    smx_timer_entry_t** slot;       /**< the head of the slot list */
+    smx_timer_entry_t*  prev;       /**< the previous entry of the slot */
+    smx_timer_entry_t*  next;       /**< the next entry of the slot */
+};
+
 /**
  * @brief timed guard to limit communication rate
  */
 struct smx_guard_s
 {
-    int             fd;     /**< file descriptor pointing to timer */
-    struct timespec iat;    /**< minumum inter-arrival-time */
+    smx_timer_entry_t   timer;      /**< the inter-arrival timer */
+    bool                is_expired; /**< true once the iat has passed */
+    pthread_mutex_t     mutex;      /**< protects the expiry flag */
+    pthread_cond_t      cv;         /**< signals the expiry */
+    struct timespec     iat;        /**< minumum inter-arrival-time */
+};
+
+/**
+ * @brief A log-linear latency histogram
+ *
+ * Values are recorded in nanoseconds into buckets of exponentially growing
+ * size where each power-of-two range is split into #SMX_HIST_SUB_COUNT linear
+ * sub-buckets (HDR-style). Recording is a constant time operation without any
+ * allocation. A histogram is written by a single thread only, concurrent
+ * readers may observe a slightly inconsistent snapshot.
+ */
+struct smx_hist_s
+{
+    uint64_t count;     /**< number of recorded values */
+    uint64_t min;       /**< smallest recorded value */
+    uint64_t max;       /**< largest recorded value */
+    uint64_t sum;       /**< sum of all recorded values */
+    uint64_t buckets[SMX_HIST_BUCKET_COUNT]; /**< the bucket counters */
+};
+
+/**
+ * @brief A hierarchical timer wheel shared by all guards and non-RT temporal
+ * firewalls
+ *
+ * A single thread sleeps on a condition variable until the earliest tick at
+ * which a timer expires or a slot cascades and skips all empty ticks. Arming
+ * and cancelling a timer only takes the wheel mutex.
+ */
+struct smx_timer_wheel_s
+{
+    /** the doubly linked timer lists of each slot of each level */
+    smx_timer_entry_t*  slots[SMX_TIMER_WHEEL_LEVELS][SMX_TIMER_WHEEL_SLOTS];
+    uint64_t            tick;       /**< the last processed tick */
+    uint64_t            next_tick;  /**< the tick the thread sleeps until */
+    int                 count;      /**< the number of armed timers */
+    bool                is_running; /**< false to stop the timer thread */
+    unsigned long       fired;      /**< the number of expired timers */
+    smx_hist_t          jitter;     /**< the expiry lateness of timers */
+    pthread_t           thread;     /**< the timer thread */
+    pthread_mutex_t     mutex;      /**< protects the wheel */
+    pthread_cond_t      cv;         /**< wakes the sleeping timer thread */
+};
+
+/**
+ * @brief An item of a hash map bucket list
+ */
+struct smx_hmap_item_s
+{
+    char*               key;    /**< the key of the item (owned by the map) */
+    uint64_t            hash;   /**< the hash of the key */
+    void*               val;    /**< the value of the item */
+    smx_hmap_item_t*    next;   /**< the next item of the bucket list */
+};
+
+/**
+ * @brief A string-keyed hash map with separate chaining
+ *
+ * The map grows automatically. It is not thread-safe.
+ */
+struct smx_hmap_s
+{
+    smx_hmap_item_t**   buckets;    /**< the bucket array */
+    unsigned int        size;       /**< the number of buckets */
+    unsigned int        count;      /**< the number of items */
 };
 
 /**
@@ -366,6 +574,172 @@ struct smx_msg_s
     void* (*unpack)( void* );       /**< pointer to a fct that unpacks data */
 };
 
+/**
+ * The loop timing statistics of a net.
+ */
+struct smx_net_stats_s
+{
+    smx_hist_t await;   /**< time spent waiting for input triggers */
+    smx_hist_t impl;    /**< time spent in the box implementation */
+    smx_hist_t loop;    /**< total time of a net loop iteration */
+    /** the dump period of the statistics in nanoseconds (0 means never) */
+    uint64_t dump_period;
+    uint64_t last_dump; /**< monotonic time of the last dump in nanoseconds */
+};
+
+/**
+ * A net executed by a cyclic executive.
+ */
+struct smx_ce_member_s
+{
+    smx_net_t* net;             /**< the net */
+    int (*impl)( void*, void* );/**< the box implementation of the net */
+    uint64_t period;            /**< the release period in ns */
+    uint64_t wcet;              /**< the execution time budget in ns or 0 */
+    uint64_t exec_max;          /**< the longest measured execution in ns */
+    unsigned long jobs;         /**< number of executed releases */
+    unsigned long overruns;     /**< number of budget overruns */
+    unsigned long misses;       /**< number of deadline misses */
+    bool is_done;               /**< the net has terminated */
+};
+
+/**
+ * A release of the schedule table of a cyclic executive.
+ */
+struct smx_ce_job_s
+{
+    uint64_t offset;            /**< offset from the hyperperiod start */
+    int member;                 /**< the index of the released net */
+    int priority;               /**< the priority of the released net */
+};
+
+/**
+ * A cyclic executive executing the nets assigned to one core.
+ */
+struct smx_ce_s
+{
+    int core;                   /**< the core the executive is pinned to */
+    int expected;               /**< number of assigned nets */
+    int count;                  /**< number of joined nets */
+    int active;                 /**< number of nets not yet terminated */
+    smx_ce_member_t* members;   /**< the joined nets */
+    smx_ce_job_t* jobs;         /**< the schedule table */
+    int job_count;              /**< number of releases in the table */
+    uint64_t hyperperiod;       /**< the length of the table in ns */
+    unsigned long cycles;       /**< number of executed hyperperiods */
+    bool is_started;            /**< the executive thread is running */
+    pthread_t thread;           /**< the executive thread */
+    pthread_mutex_t mutex;      /**< protects the members */
+    pthread_cond_t cv;          /**< signals joins and terminated nets */
+    smx_ce_t* next;             /**< the executive of another core */
+};
+
+/**
+ * The real-time memory configuration of the RTS.
+ */
+struct smx_mem_s
+{
+    bool is_locked;             /**< all pages of the process are locked */
+    size_t stack_size;          /**< the stack size of net threads or 0 */
+    size_t msg_reserve;         /**< the touched heap reserve in bytes */
+};
+
+/**
+ * The rate pacing state of a net. The net loop is released at absolute
+ * deadlines derived from the expected rate of the net.
+ */
+struct smx_net_pacer_s
+{
+    smx_net_pacing_t policy;    /**< the overrun policy */
+    uint64_t period;            /**< the loop period in nanoseconds */
+    uint64_t next;              /**< the next absolute release time in ns */
+    unsigned long overruns;     /**< number of releases late by >= 1 period */
+    unsigned long skipped;      /**< number of skipped releases */
+    smx_hist_t jitter;          /**< lateness of the loop releases */
+};
+
+/**
+ * The SCHED_DEADLINE parameters of a time-triggered net. The kernel reserves
+ * the runtime within each period and the net loop is released at absolute
+ * deadlines with the same period.
+ */
+struct smx_net_sched_dl_s
+{
+    uint64_t runtime;           /**< the reserved runtime per period in ns */
+    uint64_t deadline;          /**< the relative deadline in ns */
+    uint64_t period;            /**< the release period in ns */
+    bool is_active;             /**< the thread runs under SCHED_DEADLINE */
+};
+
+/**
+ * @brief A net configuration file which is shared by all nets referring to it
+ */
+struct smx_config_file_s
+{
+    const char* path;   /**< the path of the file (owned by the file map) */
+    bson_t*     doc;    /**< the parsed document or NULL on failure */
+};
+
+/**
+ * @brief A list of configuration files to be parsed by a pool of threads
+ */
+struct smx_config_file_job_s
+{
+    smx_config_file_t** files;  /**< the files to parse */
+    unsigned int        count;  /**< the number of files */
+    unsigned int        next;   /**< the index of the next file to parse */
+};
+
+/**
+ * @brief A node of the net property index
+ *
+ * A node represents one level of the `_nets` configuration tree, i.e.
+ * `_nets._default`, `_nets.<impl>._default`, `_nets.<impl>.<name>._default`,
+ * or `_nets.<impl>.<name>.<id>`. The parent points to the next less specific
+ * level such that property inheritance is a walk to the root.
+ */
+struct smx_net_props_node_s
+{
+    bson_t                  props;  /**< static view of the property doc */
+    bool                    has_props;  /**< false if the level is empty */
+    char*                   path;   /**< the config path of the level */
+    smx_net_props_node_t*   parent; /**< the less specific level or NULL */
+};
+
+/**
+ * @brief The net property index
+ *
+ * The `_nets` tree of the app configuration indexed by the tuples `(impl)`,
+ * `(impl, name)`, and `(impl, name, id)`. Each part of a key is prefixed with
+ * its length such that names containing dots cannot collide.
+ */
+struct smx_net_props_s
+{
+    smx_hmap_t*             nodes;  /**< all nodes except the root */
+    smx_net_props_node_t*   root;   /**< the `_nets._default` node */
+    smx_hmap_t*             files;  /**< parsed net config files by path */
+    unsigned long           lookup_cnt;  /**< number of property lookups */
+    uint64_t                index_time;  /**< time to build the index in ns */
+    uint64_t                resolve_time;/**< time to resolve props in ns */
+    uint64_t                load_time;   /**< time to load config files in ns */
+};
+
+/**
+ * @brief A pending topology change of a running net
+ *
+ * Updates are queued by the runtime topology API and applied by the thread of
+ * the net between two loop iterations such that the port arrays are only ever
+ * modified by their owner.
+ */
+struct smx_net_update_s
+{
+    smx_net_update_action_t action; /**< the change to apply */
+    smx_channel_t*      ch;         /**< the channel to (dis)connect */
+    /** mark the read end of a removed output channel as terminated */
+    bool                terminate;
+    smx_net_update_t*   next;       /**< the next queued update */
+};
+
 /**
  * Common fields of a streamix net.
  */
@@ -386,16 +760,38 @@ struct smx_net_s
     const char*         conf_port_name;
     /** read timeout on dynamic conf port in milliseconds */
     int                 conf_port_timeout;
+    /** keep reading the dynamic conf port during execution */
+    bool                has_live_conf;
+    /** number of dynamic configuration updates since init */
+    unsigned long       conf_version;
+    /** initialisation finished, protected by the RTS init mutex */
+    bool                is_ready;
+    /** the net thread executes, protected by the RTS net mutex */
+    bool                is_running;
+    bool                has_thread;   /**< the net thread must be joined */
+    pthread_t           thread;       /**< the thread of the net */
+    /** pending topology updates, protected by the RTS net mutex */
+    smx_net_update_t*   updates;
+    smx_net_t*          next;         /**< the next net created at runtime */
     void*               attr;         /**< custom attributes of special nets */
     void*               conf;         /**< pointer to the net configuration */
     bson_t*             dyn_conf;     /**< pointer to the dynamic configuration */
+    /** live configuration update not yet applied by the net thread */
+    bson_t*             conf_pending;
     bson_t*             static_conf;  /**< pointer to the static configuration */
+    /** true if the static configuration is owned by the property index */
+    bool                has_shared_conf;
     char*               name;         /**< the name of the net */
     char*               impl;         /**< the name of the box implementation */
     void*               state;
     void*               shared_state;
     const char*         shared_state_key;
     smx_rts_t*          rts;
+    smx_net_stats_t*    stats;        /**< the loop timing statistics */
+    smx_net_pacer_t*    pacer;        /**< the rate pacer or NULL */
+    smx_net_sched_dl_t* sched_dl;     /**< the deadline parameters or NULL */
+    smx_ce_t*           ce;           /**< the cyclic executive or NULL */
+    uint64_t            wcet;         /**< the execution time budget in ns */
     struct timespec     last_count_wall;   /**< start time of a net (after init) */
     struct timespec     start_wall;   /**< start time of a net (after init) */
     struct timespec     end_wall;     /**< end time of a net (befoer cleanup) */
@@ -441,6 +837,78 @@ struct smx_net_sig_s
     } source;                       /**< internal input channel for sources */
 };
 
+/**
+ * @brief A seqlock-protected record of fixed size
+ *
+ * Readers copy the record without locking and retry if a writer was active.
+ * Writers are serialised by a mutex.
+ */
+struct smx_seqlock_s
+{
+    unsigned int        seq;        /**< odd while a write is in progress */
+    size_t              size;       /**< the size of the record in bytes */
+    pthread_mutex_t     mutex;      /**< serialises writers */
+    char*               name;       /**< the name used for logging */
+    unsigned long       writes;     /**< number of writes */
+    unsigned long       read_retries;   /**< number of retried reads */
+    unsigned long       write_contended;/**< number of blocked writes */
+    smx_seqlock_t*      next;       /**< the next seqlock of the RTS */
+    unsigned char*      data;       /**< the record */
+};
+
+/**
+ * @brief An RCU-protected pointer
+ *
+ * Readers dereference the pointer within an RCU read-side critical section.
+ * Writers publish a new pointer and free the old one after a grace period.
+ */
+struct smx_rcu_ptr_s
+{
+    void*               ptr;        /**< the published pointer */
+    void ( *cleanup )( void* );     /**< frees an unpublished pointer */
+    pthread_mutex_t     mutex;      /**< serialises writers */
+    char*               name;       /**< the name used for logging */
+    unsigned long       writes;     /**< number of publications */
+    unsigned long       write_contended;/**< number of blocked publications */
+    smx_hist_t          grace;      /**< time spent waiting for readers */
+    smx_rcu_ptr_t*      next;       /**< the next RCU pointer of the RTS */
+};
+
+/**
+ * @brief A file descriptor multiplexed by the I/O thread
+ *
+ * Removed sources are only marked inactive such that events still pending in
+ * the I/O thread never refer to freed memory. They are freed with the I/O
+ * service.
+ */
+struct smx_io_source_s
+{
+    int                     fd;         /**< the file descriptor */
+    uint32_t                events;     /**< the epoll events to wait for */
+    int                     idx;        /**< the index of the source channel */
+    bool                    is_active;  /**< false once the fd is removed */
+    smx_net_t*              net;        /**< the net owning the source */
+    smx_source_fd_callback_t callback;  /**< produces a message on readiness */
+    unsigned long           dispatches; /**< the number of handled events */
+    smx_io_source_t*        next;       /**< the next source of the service */
+};
+
+/**
+ * @brief The I/O service of the RTS
+ *
+ * A single thread waits on an epoll instance for the fd sources of all nets
+ * and pushes the produced messages into the source channels of the nets.
+ */
+struct smx_io_s
+{
+    int                     epfd;       /**< the epoll instance */
+    int                     evfd;       /**< an eventfd to stop the thread */
+    pthread_t               thread;     /**< the I/O thread */
+    pthread_mutex_t         mutex;      /**< protects the source list */
+    int                     count;      /**< the number of active sources */
+    smx_io_source_t*        sources;    /**< all sources ever added */
+};
+
 /**
  * A shared state item
  */
@@ -449,7 +917,7 @@ struct smx_rts_shared_state_s
     /**
      * The name of the shared state item. This is used to reference the item.
      */
-    const char* key;
+    char* key;
     /**
      * The actual state.
      */
@@ -460,6 +928,37 @@ struct smx_rts_shared_state_s
     void ( *cleanup )( void* );
 };
 
+/**
+ * A bucket list node of the shared state registry. Nodes are only added to a
+ * bucket list head and are freed after a grace period when the table grows.
+ */
+struct smx_rts_shared_state_node_s
+{
+    smx_rts_shared_state_t*         item;   /**< the shared state item */
+    uint64_t                        hash;   /**< the hash of the item key */
+    smx_rts_shared_state_node_t*    next;   /**< the next node of the bucket */
+};
+
+/**
+ * A bucket table of the shared state registry
+ */
+struct smx_rts_shared_state_table_s
+{
+    unsigned int                    size;   /**< the number of buckets */
+    smx_rts_shared_state_node_t**   buckets;/**< the bucket array */
+};
+
+/**
+ * The shared state registry. Lookups are lock-free and protected by RCU,
+ * insertions and table growth are serialised by the registry mutex.
+ */
+struct smx_rts_shared_state_registry_s
+{
+    smx_rts_shared_state_table_t*   table;  /**< the RCU-protected table */
+    unsigned int                    count;  /**< the number of items */
+    pthread_mutex_t                 mutex;  /**< serialises writers */
+};
+
 /**
  * The main RTS structure holding information about the streamix network.
  */
@@ -467,18 +966,36 @@ struct smx_rts_s
 {
     int ch_cnt;                     /**< the number of channels of the system */
     int net_cnt;                    /**< the number of nets of the system */
-    int shared_state_cnt;
-    pthread_barrier_t pre_init_done;/**< the barrier for syncing pre initialisation */
-    pthread_barrier_t init_done;    /**< the barrier for syncing initialisation */
+    smx_net_props_t* net_props;     /**< the net property index */
+    pthread_mutex_t init_mutex;     /**< protects the net readiness flags */
+    pthread_cond_t init_cv;         /**< signals a net becoming ready */
     void* conf;                     /**< the application configuration */
     void* args;                     /**< the application arguments */
-    pthread_t ths[SMX_MAX_NETS];    /**< the array holding all thread ids */
-    smx_channel_t* chs[SMX_MAX_CHS];/**< the array holding all channel pointers */
-    smx_net_t* nets[SMX_MAX_NETS];  /**< the array holdaing all net pointers */
+    int ch_len;                     /**< the capacity of the channel table */
+    int net_len;                    /**< the capacity of the net tables */
+    pthread_t* ths;                 /**< the array holding all thread ids */
+    smx_channel_t** chs;            /**< the array holding all channel pointers */
+    smx_net_t** nets;               /**< the array holdaing all net pointers */
     struct timespec start_wall;     /**< the walltime of the application start */
     struct timespec end_wall;       /**< the walltime of the application end. */
-    smx_rts_shared_state_t* shared_state[SMX_MAX_NETS];
-    pthread_mutex_t net_mutex;      /**< mutual exclusion */
+    /** the registry of shared state items */
+    smx_rts_shared_state_registry_t* shared_state;
+    smx_net_t* dyn_nets;            /**< nets created at runtime */
+    int dyn_ch_cnt;                 /**< number of channels created at runtime */
+    int dyn_ch_len;                 /**< capacity of the runtime channel table */
+    smx_channel_t** dyn_chs;        /**< channels created at runtime */
+    smx_seqlock_t* seqlocks;        /**< all seqlocks created by boxes */
+    smx_rcu_ptr_t* rcu_ptrs;        /**< all RCU pointers created by boxes */
+    smx_io_t* io;                   /**< the I/O service, started on demand */
+    smx_mem_t mem;                  /**< the real-time memory configuration */
+    uint64_t tf_epoch;              /**< the common epoch of all tfs in ns */
+    smx_ce_t* ce;                   /**< the cyclic executives */
+    pthread_mutex_t ce_mutex;       /**< protects the list of executives */
+    /**
+     * mutual exclusion, protects the seqlock and RCU pointer lists and the
+     * runtime topology
+     */
+    pthread_mutex_t net_mutex;
 };
 
 #endif /* SMXTYPES_H */
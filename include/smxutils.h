@@ -6,12 +6,20 @@
  * Utility functions for the runtime system library of Streamix
  */
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
 
 #ifndef SMXUTILS_H
 #define SMXUTILS_H
 
 #define SMX_MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
+#define SMX_MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+
+/**
+ * The number of nanoseconds per second.
+ */
+#define SMX_NSEC_PER_SEC 1000000000ULL
 
 /**
  * ASCII definition of an input port
@@ -185,4 +193,38 @@
  */
 void* smx_malloc( size_t size );
 
+/**
+ * Get an absolute deadline on the monotonic clock which expires after a
+ * timeout. Use the deadline with condition variables initialised with
+ * CLOCK_MONOTONIC.
+ *
+ * @param timeout   the relative timeout
+ * @param deadline  an output parameter where the absolute deadline is stored
+ */
+void smx_time_get_deadline( const struct timespec* timeout,
+        struct timespec* deadline );
+
+/**
+ * Get the current time of the monotonic clock in nanoseconds.
+ *
+ * @return  the current monotonic time in nanoseconds
+ */
+uint64_t smx_time_get_ns();
+
+/**
+ * Convert a nanosecond value to a timespec structure.
+ *
+ * @param ns    the time in nanoseconds
+ * @param ts    an output parameter where the converted time is stored
+ */
+void smx_time_ns_to_timespec( uint64_t ns, struct timespec* ts );
+
+/**
+ * Convert a timespec structure to nanoseconds.
+ *
+ * @param ts    a pointer to the timespec structure to convert
+ * @return      the time in nanoseconds
+ */
+uint64_t smx_time_timespec_to_ns( const struct timespec* ts );
+
 #endif /* SMXUTILS_H */
@@ -5,14 +5,25 @@
  * Routing node box implementation for the runtime system library of Streamix
  */
 
+#include <bson.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include "box_smx_rn.h"
 #include "smxutils.h"
 #include "smxch.h"
+#include "smxconfig.h"
+#include "smxhmap.h"
 #include "smxlog.h"
 #include "smxnet.h"
 #include "smxmsg.h"
 
+static const char* smx_rn_extractor_names[SMX_RN_MAX_EXTRACTORS];
+static smx_rn_key_extractor_t smx_rn_extractors[SMX_RN_MAX_EXTRACTORS];
+static int smx_rn_extractor_count = 0;
+static pthread_mutex_t smx_rn_extractor_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*****************************************************************************/
 void smx_connect_rn( smx_channel_t* ch, smx_net_t* rn )
 {
@@ -25,7 +36,36 @@ void smx_connect_rn( smx_channel_t* ch, smx_net_t* rn )
         return;
     }
     ch->collector = rn->attr;
+    pthread_mutex_lock( &ch->collector->col_mutex );
     ch->collector->ch_count++;
+    pthread_mutex_unlock( &ch->collector->col_mutex );
+}
+
+/*****************************************************************************/
+int smx_rn_register_key_extractor( const char* name,
+        smx_rn_key_extractor_t extractor )
+{
+    int rc = 0;
+    if( name == NULL || extractor == NULL )
+        return -1;
+
+    pthread_mutex_lock( &smx_rn_extractor_mutex );
+    if( smx_rn_extractor_count >= SMX_RN_MAX_EXTRACTORS )
+    {
+        SMX_LOG_MAIN( main, error,
+                "unable to register key extractor '%s': limit of %d reached",
+                name, SMX_RN_MAX_EXTRACTORS );
+        rc = -1;
+    }
+    else
+    {
+        smx_rn_extractor_names[smx_rn_extractor_count] = name;
+        smx_rn_extractors[smx_rn_extractor_count] = extractor;
+        smx_rn_extractor_count++;
+        SMX_LOG_MAIN( main, info, "registered key extractor '%s'", name );
+    }
+    pthread_mutex_unlock( &smx_rn_extractor_mutex );
+    return rc;
 }
 
 /*****************************************************************************/
@@ -48,25 +88,248 @@ void smx_net_init_rn( smx_net_t* rn )
     rn->attr = smx_collector_create();
 }
 
+/*****************************************************************************/
+static bool smx_rn_is_writable( smx_channel_t* ch )
+{
+    return ch != NULL && ch->sink->state != SMX_CHANNEL_END
+        && ch->fifo->count < ch->fifo->length;
+}
+
+/*****************************************************************************/
+static int smx_rn_select( net_smx_rn_state_t* rn_state, smx_channel_t** chs,
+        int count )
+{
+    int i;
+    int idx;
+    int fifo_count;
+    int selected = -1;
+    int min_count = 0;
+
+    // only the routing node writes to its outputs, the consumers can only
+    // free space, hence, a writable output does not block
+    for( i = 0; i < count; i++ )
+    {
+        idx = ( rn_state->next_out + i ) % count;
+        if( !smx_rn_is_writable( chs[idx] ) )
+            continue;
+
+        fifo_count = chs[idx]->fifo->count;
+        if( rn_state->mode == SMX_RN_MODE_ROUND_ROBIN )
+        {
+            selected = idx;
+            break;
+        }
+        else if( rn_state->mode == SMX_RN_MODE_FIRST_READY )
+        {
+            // the first idle consumer, else the first output with space
+            if( fifo_count == 0 )
+            {
+                selected = idx;
+                break;
+            }
+            if( selected < 0 )
+                selected = idx;
+        }
+        else if( selected < 0 || fifo_count < min_count )
+        {
+            selected = idx;
+            min_count = fifo_count;
+        }
+    }
+
+    if( selected < 0 )
+    {
+        // no output has space, block on the next output in turn
+        selected = rn_state->next_out % count;
+        rn_state->blocked++;
+    }
+    if( rn_state->mode != SMX_RN_MODE_FIRST_READY )
+        rn_state->next_out = ( selected + 1 ) % count;
+    return selected;
+}
+
+/*****************************************************************************/
+static const char* smx_rn_get_field( smx_msg_t* msg, const char* path,
+        char* buf, size_t len )
+{
+    bson_t doc;
+    bson_iter_t iter;
+    bson_iter_t child;
+
+    if( msg->data == NULL || msg->size <= 0
+            || !bson_init_static( &doc, msg->data, msg->size ) )
+        return NULL;
+    if( !bson_iter_init( &iter, &doc )
+            || !bson_iter_find_descendant( &iter, path, &child ) )
+        return NULL;
+
+    switch( bson_iter_type( &child ) )
+    {
+        case BSON_TYPE_UTF8:
+            return bson_iter_utf8( &child, NULL );
+        case BSON_TYPE_INT32:
+            snprintf( buf, len, "%d", bson_iter_int32( &child ) );
+            return buf;
+        case BSON_TYPE_INT64:
+            snprintf( buf, len, "%lld",
+                    ( long long )bson_iter_int64( &child ) );
+            return buf;
+        case BSON_TYPE_BOOL:
+            return bson_iter_bool( &child ) ? "true" : "false";
+        default:
+            return NULL;
+    }
+}
+
+/*****************************************************************************/
+static smx_rn_route_t* smx_rn_route_lookup( net_smx_rn_state_t* rn_state,
+        smx_msg_t* msg )
+{
+    char buf[32];
+    const char* value;
+    smx_rn_route_t* route = NULL;
+
+    if( rn_state->values != NULL )
+    {
+        value = smx_rn_get_field( msg, rn_state->field, buf, sizeof( buf ) );
+        if( value != NULL )
+            route = smx_hmap_get( rn_state->values, value );
+    }
+    if( route == NULL && rn_state->types != NULL && msg->type != NULL )
+        route = smx_hmap_get( rn_state->types, msg->type );
+    if( route == NULL )
+        route = rn_state->fallback;
+    return route;
+}
+
+/*****************************************************************************/
+static void smx_rn_write_route( void* h, net_smx_rn_state_t* rn_state,
+        smx_msg_t* msg, smx_rn_route_t* route, smx_channel_t** chs, int count )
+{
+    int i;
+    int idx;
+    int last = -1;
+
+    if( route != NULL )
+    {
+        for( i = 0; i < route->count; i++ )
+        {
+            idx = route->ports[i];
+            if( idx < count && chs[idx] != NULL )
+                last = i;
+        }
+    }
+    if( last < 0 )
+    {
+        SMX_LOG_NET( h, debug, "no route for msg, msg dismissed (%llu)",
+                msg->id );
+        rn_state->dropped++;
+        smx_msg_destroy( h, msg, 1 );
+        return;
+    }
+
+    // copy only to the matching outputs, the last one gets the original
+    for( i = 0; i < last; i++ )
+    {
+        idx = route->ports[i];
+        if( idx < count && chs[idx] != NULL )
+            smx_channel_write( h, chs[idx], smx_msg_copy( h, msg ) );
+    }
+    smx_channel_write( h, chs[route->ports[last]], msg );
+}
+
+/*****************************************************************************/
+static int smx_rn_partition_select( net_smx_rn_state_t* rn_state,
+        smx_msg_t* msg, int count )
+{
+    char buf[32];
+    size_t len = 0;
+    const void* key = NULL;
+    uint64_t hash;
+    int64_t b = -1;
+    int64_t j = 0;
+
+    if( rn_state->extractor != NULL )
+        key = rn_state->extractor( msg, &len );
+    else if( rn_state->field != NULL )
+    {
+        key = smx_rn_get_field( msg, rn_state->field, buf, sizeof( buf ) );
+        if( key != NULL )
+            len = strlen( key );
+    }
+    if( key == NULL )
+    {
+        rn_state->unkeyed++;
+        key = "";
+        len = 0;
+    }
+    hash = smx_hmap_hash( key, len );
+
+    // jump consistent hash (Lamping and Veach): stable for a fixed count and
+    // only 1/count of the keys move if an output is added
+    while( j < count )
+    {
+        b = j;
+        hash = hash * 2862933555777941757ULL + 1;
+        j = ( b + 1 ) * ( ( double )( 1LL << 31 )
+                / ( double )( ( hash >> 33 ) + 1 ) );
+    }
+    return ( int )b;
+}
+
 /*****************************************************************************/
 int smx_rn( void* h, void* state )
 {
-    int* last_idx = ( int* )state;
+    net_smx_rn_state_t* rn_state = state;
     int i;
     smx_net_t* net = h;
 
     smx_msg_t* msg;
     smx_msg_t* msg_copy;
     int count_in = net->sig->in.len;
-    int count_out = net->sig->out.len;
+    int count_out;
     smx_channel_t** chs_in = net->sig->in.ports;
-    smx_channel_t** chs_out = net->sig->out.ports;
+    smx_channel_t** chs_out;
     smx_collector_t* collector = net->attr;
 
-    msg = smx_net_collector_read( h, collector, chs_in, count_in, last_idx );
+    msg = smx_net_collector_read( h, collector, chs_in, count_in,
+            &rn_state->last_idx );
     if( msg == NULL )
         return SMX_NET_END;
 
+    // the output ports may change while waiting on the collector
+    count_out = net->sig->out.len;
+    chs_out = net->sig->out.ports;
+
+    if( rn_state->mode == SMX_RN_MODE_CONTENT )
+    {
+        smx_rn_write_route( h, rn_state, msg,
+                smx_rn_route_lookup( rn_state, msg ), chs_out, count_out );
+        return SMX_NET_RETURN;
+    }
+    else if( rn_state->mode == SMX_RN_MODE_PARTITION )
+    {
+        i = ( count_out > 0 )
+            ? smx_rn_partition_select( rn_state, msg, count_out ) : -1;
+        if( i < 0 || chs_out[i] == NULL )
+        {
+            // never re-route a key, this would break the partition
+            SMX_LOG_NET( h, debug, "partition not connected, msg dismissed"
+                    " (%llu)", msg->id );
+            rn_state->dropped++;
+            smx_msg_destroy( h, msg, 1 );
+        }
+        else
+            smx_channel_write( h, chs_out[i], msg );
+        return SMX_NET_RETURN;
+    }
+    else if( rn_state->mode != SMX_RN_MODE_BROADCAST && count_out > 0 )
+    {
+        i = smx_rn_select( rn_state, chs_out, count_out );
+        smx_channel_write( h, chs_out[i], msg );
+        return SMX_NET_RETURN;
+    }
+
     for( i = 0; i < count_out; i++ )
     {
         if( i == count_out - 1 )
@@ -83,24 +346,246 @@ int smx_rn( void* h, void* state )
     return SMX_NET_RETURN;
 }
 
+/*****************************************************************************/
+static void smx_rn_route_destroy( void* item )
+{
+    smx_rn_route_t* route = item;
+    if( route == NULL )
+        return;
+    if( route->ports != NULL )
+        free( route->ports );
+    free( route );
+}
+
+/*****************************************************************************/
+static smx_rn_route_t* smx_rn_route_create( void* h, bson_iter_t* iter,
+        const char* key )
+{
+    int i = 0;
+    bson_iter_t child;
+    smx_rn_route_t* route;
+
+    if( !BSON_ITER_HOLDS_ARRAY( iter ) || !bson_iter_recurse( iter, &child ) )
+    {
+        SMX_LOG_NET( h, error, "route '%s' is not an array of ports", key );
+        return NULL;
+    }
+
+    route = smx_malloc( sizeof( struct smx_rn_route_s ) );
+    if( route == NULL )
+        return NULL;
+    route->count = 0;
+    while( bson_iter_next( &child ) )
+        route->count++;
+    route->ports = smx_malloc( sizeof( int ) * ( route->count + 1 ) );
+    if( route->ports == NULL )
+    {
+        free( route );
+        return NULL;
+    }
+
+    bson_iter_recurse( iter, &child );
+    while( bson_iter_next( &child ) )
+    {
+        if( !BSON_ITER_HOLDS_INT32( &child ) || bson_iter_int32( &child ) < 0 )
+        {
+            SMX_LOG_NET( h, error, "route '%s' has an invalid port index",
+                    key );
+            smx_rn_route_destroy( route );
+            return NULL;
+        }
+        route->ports[i++] = bson_iter_int32( &child );
+    }
+    return route;
+}
+
+/*****************************************************************************/
+static smx_hmap_t* smx_rn_routes_create( void* h, bson_t* conf,
+        const char* search )
+{
+    bson_iter_t iter;
+    bson_iter_t child;
+    smx_hmap_t* routes;
+    smx_rn_route_t* route;
+
+    if( !bson_iter_init( &iter, conf )
+            || !bson_iter_find_descendant( &iter, search, &child ) )
+        return NULL;
+    if( !BSON_ITER_HOLDS_DOCUMENT( &child )
+            || !bson_iter_recurse( &child, &iter ) )
+    {
+        SMX_LOG_NET( h, error, "'%s' is not a routing table", search );
+        return NULL;
+    }
+
+    routes = smx_hmap_create( 16 );
+    if( routes == NULL )
+        return NULL;
+    while( bson_iter_next( &iter ) )
+    {
+        route = smx_rn_route_create( h, &iter, bson_iter_key( &iter ) );
+        if( route == NULL )
+            continue;
+        if( smx_hmap_put( routes, bson_iter_key( &iter ), route ) < 0 )
+            smx_rn_route_destroy( route );
+    }
+    return routes;
+}
+
+/*****************************************************************************/
+static void smx_rn_routes_init( void* h, net_smx_rn_state_t* rn_state,
+        bson_t* conf )
+{
+    const char* field;
+    bson_iter_t iter;
+    bson_iter_t child;
+
+    rn_state->types = smx_rn_routes_create( h, conf, "routes.types" );
+    field = smx_config_get_string( conf, "routes.field", NULL );
+    if( field != NULL )
+    {
+        rn_state->field = strdup( field );
+        rn_state->values = smx_rn_routes_create( h, conf, "routes.values" );
+        SMX_LOG_NET( h, notice, "routing by the value of field '%s'", field );
+    }
+    if( bson_iter_init( &iter, conf )
+            && bson_iter_find_descendant( &iter, "routes.default", &child ) )
+        rn_state->fallback = smx_rn_route_create( h, &child, "default" );
+
+    if( rn_state->types == NULL && rn_state->values == NULL
+            && rn_state->fallback == NULL )
+    {
+        SMX_LOG_NET( h, warn, "empty routing table, all msgs are dismissed" );
+    }
+}
+
+/*****************************************************************************/
+static void smx_rn_partition_init( void* h, net_smx_rn_state_t* rn_state,
+        bson_t* conf )
+{
+    int i;
+    const char* name;
+    const char* key;
+
+    name = smx_config_get_string( conf, "partition.extractor", NULL );
+    key = smx_config_get_string( conf, "partition.key", NULL );
+    if( name != NULL )
+    {
+        pthread_mutex_lock( &smx_rn_extractor_mutex );
+        for( i = 0; i < smx_rn_extractor_count; i++ )
+        {
+            if( strcmp( smx_rn_extractor_names[i], name ) == 0 )
+            {
+                rn_state->extractor = smx_rn_extractors[i];
+                break;
+            }
+        }
+        pthread_mutex_unlock( &smx_rn_extractor_mutex );
+        if( rn_state->extractor == NULL )
+        {
+            SMX_LOG_NET( h, error, "unknown key extractor '%s'", name );
+        }
+        else
+        {
+            SMX_LOG_NET( h, notice, "partitioning by key extractor '%s'",
+                    name );
+        }
+    }
+    if( rn_state->extractor == NULL && key != NULL )
+    {
+        rn_state->field = strdup( key );
+        SMX_LOG_NET( h, notice, "partitioning by the value of field '%s'",
+                key );
+    }
+    if( rn_state->extractor == NULL && rn_state->field == NULL )
+    {
+        SMX_LOG_NET( h, warn,
+                "no partition key, all msgs are written to the same output" );
+    }
+}
+
 /*****************************************************************************/
 int smx_rn_init( void* h, void** state )
 {
-    ( void )( h );
-    *state = smx_malloc( sizeof( int ) );
-    if( *state == NULL )
+    const char* mode;
+    net_smx_rn_state_t* rn_state;
+
+    rn_state = smx_malloc( sizeof( struct net_smx_rn_state_s ) );
+    if( rn_state == NULL )
         return -1;
 
-    *( int* )( *state ) = 0;
+    rn_state->last_idx = 0;
+    rn_state->next_out = 0;
+    rn_state->blocked = 0;
+    rn_state->dropped = 0;
+    rn_state->unkeyed = 0;
+    rn_state->field = NULL;
+    rn_state->types = NULL;
+    rn_state->values = NULL;
+    rn_state->fallback = NULL;
+    rn_state->extractor = NULL;
+    rn_state->mode = SMX_RN_MODE_BROADCAST;
+    mode = smx_config_get_string( SMX_NET_GET_CONF( h ), "mode", NULL );
+    if( mode == NULL || strcmp( mode, "broadcast" ) == 0 )
+        rn_state->mode = SMX_RN_MODE_BROADCAST;
+    else if( strcmp( mode, "round_robin" ) == 0 )
+        rn_state->mode = SMX_RN_MODE_ROUND_ROBIN;
+    else if( strcmp( mode, "least_loaded" ) == 0 )
+        rn_state->mode = SMX_RN_MODE_LEAST_LOADED;
+    else if( strcmp( mode, "first_ready" ) == 0 )
+        rn_state->mode = SMX_RN_MODE_FIRST_READY;
+    else if( strcmp( mode, "content" ) == 0 )
+    {
+        rn_state->mode = SMX_RN_MODE_CONTENT;
+        smx_rn_routes_init( h, rn_state, SMX_NET_GET_CONF( h ) );
+    }
+    else if( strcmp( mode, "partition" ) == 0 )
+    {
+        rn_state->mode = SMX_RN_MODE_PARTITION;
+        smx_rn_partition_init( h, rn_state, SMX_NET_GET_CONF( h ) );
+    }
+    else
+    {
+        SMX_LOG_NET( h, warn, "unknown routing mode '%s', using broadcast",
+                mode );
+    }
+    if( mode != NULL )
+    {
+        SMX_LOG_NET( h, notice, "setting property 'mode' to '%s'", mode );
+    }
+
+    *state = rn_state;
     return 0;
 }
 
 /*****************************************************************************/
 void smx_rn_cleanup( void* h, void* state )
 {
-    ( void )( h );
-    if( state != NULL )
-        free( state );
+    net_smx_rn_state_t* rn_state = state;
+    if( rn_state == NULL )
+        return;
+
+    if( rn_state->mode == SMX_RN_MODE_CONTENT )
+    {
+        SMX_LOG_NET( h, notice, "%lu messages were dismissed without route",
+                rn_state->dropped );
+    }
+    else if( rn_state->mode == SMX_RN_MODE_PARTITION )
+    {
+        SMX_LOG_NET( h, notice, "%lu messages had no key, %lu messages were"
+                " dismissed", rn_state->unkeyed, rn_state->dropped );
+    }
+    else if( rn_state->mode != SMX_RN_MODE_BROADCAST )
+    {
+        SMX_LOG_NET( h, notice, "%lu messages found no output with space",
+                rn_state->blocked );
+    }
+    smx_hmap_destroy( rn_state->types, smx_rn_route_destroy );
+    smx_hmap_destroy( rn_state->values, smx_rn_route_destroy );
+    smx_rn_route_destroy( rn_state->fallback );
+    if( rn_state->field != NULL )
+        free( rn_state->field );
+    free( state );
 }
 
 /*****************************************************************************/
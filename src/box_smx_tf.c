@@ -6,11 +6,15 @@
  * Streamix
  */
 
+#define _GNU_SOURCE
 #include <errno.h>
-#include <poll.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <sys/timerfd.h>
+#include <time.h>
 #include <unistd.h>
 #include "box_smx_tf.h"
 #include "smxch.h"
@@ -19,8 +23,31 @@
 #include "smxnet.h"
 #include "smxmsg.h"
 #include "smxprofiler.h"
+#include "smxstats.h"
+#include "smxtimer.h"
 #include "smxutils.h"
 
+/**
+ * The maximal number of propagations within one hyperperiod. Beyond this the
+ * dispatch table would get too large and all pairs run at the fastest rate.
+ */
+#define SMX_TF_MAX_DISPATCH 65536
+
+/**
+ * The maximal number of chained temporal firewalls which are considered for
+ * the end-to-end latency bound. This also breaks cycles.
+ */
+#define SMX_TF_MAX_STAGES 32
+
+/**
+ * A propagation instant of a port pair, used to build the dispatch table.
+ */
+struct smx_tf_instant_s
+{
+    uint64_t offset;
+    int pair;
+};
+
 /*****************************************************************************/
 void smx_connect_tf( smx_net_t* net, smx_channel_t* ch_in,
         smx_channel_t* ch_out )
@@ -32,6 +59,22 @@ void smx_connect_tf( smx_net_t* net, smx_channel_t* ch_in,
                 "unable to connect tf: timer not initialised" );
         return;
     }
+    smx_connect_tf_rate( net, ch_in, ch_out, timer->itval.it_interval.tv_sec,
+            timer->itval.it_interval.tv_nsec, 0, 0 );
+}
+
+/*****************************************************************************/
+void smx_connect_tf_rate( smx_net_t* net, smx_channel_t* ch_in,
+        smx_channel_t* ch_out, int sec, int nsec, int phase_sec,
+        int phase_nsec )
+{
+    smx_timer_t* timer = net->attr;
+    if( net == NULL || timer == NULL )
+    {
+        SMX_LOG_MAIN( main, fatal,
+                "unable to connect tf: timer not initialised" );
+        return;
+    }
 
     SMX_LOG_MAIN( ch, info, "connect '%s(%d)%s%s(%d)'", ch_in->name,
             ch_in->id, SMX_MODE_in, "smx_tf", net->id );
@@ -44,6 +87,14 @@ void smx_connect_tf( smx_net_t* net, smx_channel_t* ch_in,
     tf->in->source->net = net;
     tf->out = ch_out;
     tf->out->sink->net = net;
+    tf->period = ( uint64_t )sec * SMX_NSEC_PER_SEC + nsec;
+    tf->phase = ( uint64_t )phase_sec * SMX_NSEC_PER_SEC + phase_nsec;
+    if( tf->period == 0 )
+    {
+        SMX_LOG_MAIN( main, error, "tf pair '%s' has no period, using the tf"
+                " period", ch_in->name );
+        tf->period = smx_time_timespec_to_ns( &timer->itval.it_interval );
+    }
     tf->next = timer->tfs;
     timer->tfs = tf;
     timer->count++;
@@ -65,6 +116,64 @@ smx_timer_t* smx_net_create_tf( int sec, int nsec )
         SMX_LOG_MAIN( main, error, "timerfd_create: %d", errno );
     timer->count = 0;
     timer->tfs = NULL;
+    timer->use_wheel = false;
+    timer->hyperperiod = 0;
+    timer->slots = NULL;
+    timer->slot_count = 0;
+    timer->slot = 0;
+    timer->cycle = 0;
+    timer->epoch = 0;
+    timer->phase = 0;
+    timer->is_handoff = NULL;
+    timer->stats.dispatches = 0;
+    timer->stats.missed = 0;
+    smx_hist_init( &timer->stats.wakeup );
+    smx_hist_init( &timer->stats.propagation );
+    return timer;
+}
+
+/*****************************************************************************/
+static void smx_net_tick_tf( void* arg )
+{
+    smx_timer_t* timer = arg;
+    pthread_mutex_lock( &timer->mutex );
+    timer->ticks++;
+    pthread_cond_signal( &timer->cv );
+    pthread_mutex_unlock( &timer->mutex );
+}
+
+/*****************************************************************************/
+static smx_timer_t* smx_net_create_tf_wheel( int sec, int nsec )
+{
+    smx_timer_t* timer = smx_malloc( sizeof( struct smx_timer_s ) );
+    if( timer == NULL )
+        return NULL;
+
+    timer->itval.it_value.tv_sec = sec;
+    timer->itval.it_value.tv_nsec = nsec;
+    timer->itval.it_interval.tv_sec = sec;
+    timer->itval.it_interval.tv_nsec = nsec;
+    timer->fd = -1;
+    timer->count = 0;
+    timer->tfs = NULL;
+    timer->use_wheel = true;
+    timer->hyperperiod = 0;
+    timer->slots = NULL;
+    timer->slot_count = 0;
+    timer->slot = 0;
+    timer->cycle = 0;
+    timer->epoch = 0;
+    timer->phase = 0;
+    timer->is_handoff = NULL;
+    timer->stats.dispatches = 0;
+    timer->stats.missed = 0;
+    smx_hist_init( &timer->stats.wakeup );
+    smx_hist_init( &timer->stats.propagation );
+    timer->ticks = 0;
+    timer->seen = 0;
+    pthread_mutex_init( &timer->mutex, NULL );
+    pthread_cond_init( &timer->cv, NULL );
+    smx_timer_init( &timer->tick, smx_net_tick_tf, timer );
     return timer;
 }
 
@@ -74,6 +183,7 @@ void smx_net_destroy_tf( smx_net_t* net )
     if( net == NULL )
         return;
 
+    int i;
     smx_timer_t* tt = net->attr;
     net_smx_tf_t* tf = tt->tfs;
     net_smx_tf_t* tf_tmp;
@@ -82,16 +192,154 @@ void smx_net_destroy_tf( smx_net_t* net )
         tf = tf->next;
         free( tf_tmp );
     }
-    close( tt->fd );
+    for( i = 0; i < tt->slot_count; i++ )
+        free( tt->slots[i].pairs );
+    free( tt->slots );
+    free( tt->is_handoff );
+    if( tt->use_wheel )
+    {
+        smx_timer_cancel( &tt->tick );
+        pthread_mutex_destroy( &tt->mutex );
+        pthread_cond_destroy( &tt->cv );
+    }
+    else
+        close( tt->fd );
     free( tt );
 }
 
+/*****************************************************************************/
+static uint64_t smx_tf_gcd( uint64_t a, uint64_t b )
+{
+    uint64_t tmp;
+    while( b != 0 )
+    {
+        tmp = a % b;
+        a = b;
+        b = tmp;
+    }
+    return a;
+}
+
+/*****************************************************************************/
+static int smx_tf_instant_cmp( const void* a, const void* b )
+{
+    const struct smx_tf_instant_s* ia = a;
+    const struct smx_tf_instant_s* ib = b;
+    if( ia->offset != ib->offset )
+        return ( ia->offset < ib->offset ) ? -1 : 1;
+    return ia->pair - ib->pair;
+}
+
+/*****************************************************************************/
+static int smx_net_schedule_tf( smx_net_t* net )
+{
+    int i;
+    int j;
+    uint64_t k;
+    uint64_t dispatch_cnt = 0;
+    uint64_t hyperperiod = 1;
+    uint64_t min_period = UINT64_MAX;
+    bool is_bounded = true;
+    smx_timer_t* tt = net->attr;
+    net_smx_tf_t* tf;
+    struct smx_tf_instant_s* instants;
+
+    if( tt->count == 0 )
+    {
+        tt->hyperperiod = smx_time_timespec_to_ns( &tt->itval.it_interval );
+        return 0;
+    }
+
+    // the pair periods are in port order
+    uint64_t periods[tt->count];
+    uint64_t phases[tt->count];
+    for( i = 0, tf = tt->tfs; i < tt->count; i++, tf = tf->next )
+    {
+        periods[i] = tf->period;
+        phases[i] = tf->phase % tf->period;
+        if( tf->period < min_period )
+            min_period = tf->period;
+        if( is_bounded )
+        {
+            hyperperiod = hyperperiod / smx_tf_gcd( hyperperiod, tf->period );
+            if( hyperperiod > UINT64_MAX / tf->period )
+                is_bounded = false;
+            else
+                hyperperiod *= tf->period;
+        }
+    }
+    for( i = 0; is_bounded && i < tt->count; i++ )
+    {
+        dispatch_cnt += hyperperiod / periods[i];
+        if( dispatch_cnt > SMX_TF_MAX_DISPATCH )
+            is_bounded = false;
+    }
+    if( !is_bounded )
+    {
+        SMX_LOG_NET( net, error, "tf hyperperiod too large for a dispatch"
+                " table, all pairs run every %lu ns", min_period );
+        hyperperiod = min_period;
+        dispatch_cnt = tt->count;
+        for( i = 0; i < tt->count; i++ )
+        {
+            periods[i] = min_period;
+            phases[i] = 0;
+        }
+    }
+
+    instants = smx_malloc( sizeof( struct smx_tf_instant_s ) * dispatch_cnt );
+    if( instants == NULL )
+        return -1;
+    for( i = 0, j = 0; i < tt->count; i++ )
+    {
+        for( k = phases[i]; k < hyperperiod; k += periods[i] )
+        {
+            instants[j].offset = k;
+            instants[j].pair = i;
+            j++;
+        }
+    }
+    qsort( instants, dispatch_cnt, sizeof( struct smx_tf_instant_s ),
+            smx_tf_instant_cmp );
+
+    // group the instants with the same offset into one slot
+    tt->slots = smx_malloc( sizeof( struct smx_tf_slot_s ) * dispatch_cnt );
+    if( tt->slots == NULL )
+    {
+        free( instants );
+        return -1;
+    }
+    tt->slot_count = 0;
+    for( j = 0; j < ( int )dispatch_cnt; j = i )
+    {
+        for( i = j; i < ( int )dispatch_cnt
+                && instants[i].offset == instants[j].offset; i++ );
+        tt->slots[tt->slot_count].offset = instants[j].offset;
+        tt->slots[tt->slot_count].count = i - j;
+        tt->slots[tt->slot_count].pairs = smx_malloc( sizeof( int ) * ( i - j ) );
+        for( k = 0; k < ( uint64_t )( i - j ); k++ )
+            tt->slots[tt->slot_count].pairs[k] = instants[j + k].pair;
+        tt->slot_count++;
+    }
+    tt->hyperperiod = hyperperiod;
+    free( instants );
+
+    SMX_LOG_NET( net, notice, "tf schedule: %d pairs, hyperperiod %lu ns,"
+            " %d dispatch instants", tt->count, tt->hyperperiod,
+            tt->slot_count );
+    return 0;
+}
+
 /*****************************************************************************/
 void smx_net_finalize_tf( smx_net_t* net )
 {
     int i;
+    int phase_sec = 0;
+    int phase_nsec = 0;
     smx_timer_t* tt = net->attr;
     net_smx_tf_t* tf = tt->tfs;
+    free( net->sig->in.ports );
+    free( net->sig->out.ports );
     net->sig->in.ports = smx_malloc( sizeof( struct smx_channel_s ) * tt->count );
     net->sig->in.count = net->sig->in.len = tt->count;
     net->sig->out.ports = smx_malloc( sizeof( struct smx_channel_s ) * tt->count );
@@ -102,27 +350,230 @@ void smx_net_finalize_tf( smx_net_t* net )
         net->sig->out.ports[i] = tf->out;
         tf = tf->next;
     }
+    if( smx_net_schedule_tf( net ) < 0 )
+    {
+        // without a dispatch table all pairs run with the tf period
+        SMX_LOG_NET( net, error, "failed to compute the tf schedule" );
+        tt->slots = NULL;
+        tt->slot_count = 0;
+        tt->hyperperiod = smx_time_timespec_to_ns( &tt->itval.it_interval );
+    }
+    if( net->static_conf != NULL )
+    {
+        smx_config_init_int( net->static_conf, "phase_sec", &phase_sec );
+        smx_config_init_int( net->static_conf, "phase_nsec", &phase_nsec );
+    }
+    tt->phase = ( uint64_t )phase_sec * SMX_NSEC_PER_SEC + phase_nsec;
+}
+
+/*****************************************************************************/
+smx_tf_stats_t* smx_net_get_tf_stats( smx_net_t* net )
+{
+    smx_timer_t* timer;
+    if( net == NULL || net->attr == NULL )
+        return NULL;
+
+    timer = net->attr;
+    return &timer->stats;
+}
+
+/*****************************************************************************/
+static net_smx_tf_t* smx_tf_get_pair( smx_timer_t* tt, int pair )
+{
+    int i;
+    net_smx_tf_t* tf = tt->tfs;
+    for( i = 0; i < pair && tf != NULL; i++ )
+        tf = tf->next;
+    return tf;
+}
+
+/*****************************************************************************/
+static uint64_t smx_tf_get_stage_bound( uint64_t period_up,
+        uint64_t phase_up, uint64_t period, uint64_t phase )
+{
+    uint64_t k;
+    uint64_t t;
+    uint64_t gap;
+    uint64_t bound = 0;
+    uint64_t count = period / smx_tf_gcd( period_up, period );
+
+    if( count > SMX_TF_MAX_DISPATCH )
+        return period;
+
+    // the upstream instants repeat with respect to the downstream period
+    for( k = 0; k < count; k++ )
+    {
+        t = ( phase_up + k * ( period_up % period ) ) % period;
+        gap = ( phase + period - t ) % period;
+        if( gap == 0 )
+            gap = period;
+        if( gap > bound )
+            bound = gap;
+    }
+    return bound;
+}
+
+/*****************************************************************************/
+static uint64_t smx_tf_get_chain_bound( smx_net_t* net, int pair, int depth,
+        int* stages )
+{
+    int i;
+    int j;
+    int up_stages;
+    uint64_t bound = 0;
+    uint64_t up_bound;
+    smx_timer_t* tt = net->attr;
+    smx_timer_t* tt_up;
+    net_smx_tf_t* tf = smx_tf_get_pair( tt, pair );
+    net_smx_tf_t* tf_up;
+    smx_net_t* producer;
+    smx_net_t* up;
+    smx_channel_t* ch;
+
+    *stages = 1;
+    if( tf == NULL || depth >= SMX_TF_MAX_STAGES )
+        return 0;
+
+    producer = tf->in->sink->net;
+    if( producer == NULL || producer->sig == NULL )
+        return 0;
+
+    for( i = 0; i < producer->sig->in.count; i++ )
+    {
+        ch = producer->sig->in.ports[i];
+        up = ( ch == NULL || ch->sink == NULL ) ? NULL : ch->sink->net;
+        if( up == NULL || up->impl == NULL || up->attr == NULL
+                || strcmp( up->impl, "smx_tf" ) != 0 )
+            continue;
+
+        tt_up = up->attr;
+        for( j = 0; j < up->sig->out.count; j++ )
+        {
+            if( up->sig->out.ports[j] != ch )
+                continue;
+            tf_up = smx_tf_get_pair( tt_up, j );
+            if( tf_up == NULL )
+                break;
+            up_bound = smx_tf_get_stage_bound( tf_up->period,
+                    ( tt_up->phase + tf_up->phase ) % tf_up->period,
+                    tf->period, ( tt->phase + tf->phase ) % tf->period );
+            up_bound += smx_tf_get_chain_bound( up, j, depth + 1,
+                    &up_stages );
+            if( up_bound > bound )
+            {
+                bound = up_bound;
+                *stages = up_stages + 1;
+            }
+            break;
+        }
+    }
+    return bound;
+}
+
+/*****************************************************************************/
+uint64_t smx_tf_get_latency_bound( smx_net_t* net, int pair, int* stages )
+{
+    int count;
+
+    if( stages == NULL )
+        stages = &count;
+    *stages = 0;
+    if( net == NULL || net->attr == NULL || pair < 0
+            || pair >= ( ( smx_timer_t* )net->attr )->count )
+        return 0;
+
+    return smx_tf_get_chain_bound( net, pair, 0, stages );
 }
 
 /*****************************************************************************/
 void smx_net_init_tf( smx_net_t* net, int sec, int nsec )
 {
-    net->attr = smx_net_create_tf( sec, nsec );
+    // only RT firewalls need a dedicated kernel timer
+    if( net->priority > 0 )
+        net->attr = smx_net_create_tf( sec, nsec );
+    else
+        net->attr = smx_net_create_tf_wheel( sec, nsec );
 }
 
 /*****************************************************************************/
 void smx_tf_enable( smx_net_t* h )
 {
+    int i;
+    int stages;
+    int handoff_count = 0;
+    uint64_t bound;
     smx_timer_t* timer = h->attr;
     if( h == NULL || timer == NULL )
         return;
 
-    if( -1 == timerfd_settime( timer->fd, 0, &timer->itval, NULL ) )
-        SMX_LOG_NET( h, error, "timerfd_settime: %d", errno );
+    free( timer->is_handoff );
+    timer->is_handoff = smx_malloc( sizeof( bool ) * ( timer->count + 1 ) );
+    if( timer->is_handoff != NULL && h->sig->out.ports != NULL )
+    {
+        for( i = 0; i < timer->count; i++ )
+        {
+            timer->is_handoff[i] = smx_channel_is_handoff_capable(
+                    h->sig->out.ports[i] );
+            if( timer->is_handoff[i] )
+                handoff_count++;
+        }
+        SMX_LOG_NET( h, notice, "%d of %d port pairs propagate by handoff",
+                handoff_count, timer->count );
+    }
+
+    for( i = 0; i < timer->count; i++ )
+    {
+        bound = smx_tf_get_latency_bound( h, i, &stages );
+        if( stages > 1 )
+        {
+            SMX_LOG_NET( h, notice, "latency bound of pair '%s': %lu ns over"
+                    " %d chained tfs", h->sig->in.ports[i]->name, bound,
+                    stages );
+        }
+    }
+
+    // the epoch is aligned on the first dispatch, i.e. once all nets are ready
+    timer->epoch = 0;
+    timer->cycle = 0;
+    timer->slot = 0;
+}
+
+/*****************************************************************************/
+static void smx_tf_align_epoch( smx_net_t* h )
+{
+    uint64_t now;
+    uint64_t epoch;
+    smx_timer_t* timer = h->attr;
+
+    // all instants of the dispatch table are relative to the common epoch
+    now = smx_time_get_ns();
+    epoch = 0;
+    if( !__atomic_compare_exchange_n( &h->rts->tf_epoch, &epoch, now, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+    {
+        SMX_LOG_NET( h, debug, "align to common tf epoch %lu", epoch );
+    }
+    else
+    {
+        epoch = now;
+    }
+    timer->epoch = epoch + timer->phase;
+    if( timer->epoch < now && timer->hyperperiod > 0 )
+    {
+        timer->epoch += ( ( now - timer->epoch + timer->hyperperiod - 1 )
+                / timer->hyperperiod ) * timer->hyperperiod;
+    }
 }
 
 /*****************************************************************************/
 void smx_tf_propagate_msgs( smx_net_t* h, int copy )
+{
+    smx_tf_propagate_shard( h, copy, 0, 1 );
+}
+
+/*****************************************************************************/
+void smx_tf_propagate_shard( smx_net_t* h, int copy, int shard,
+        int shard_count )
 {
     int i;
     smx_timer_t* tt = h->attr;
@@ -131,10 +582,16 @@ void smx_tf_propagate_msgs( smx_net_t* h, int copy )
     smx_msg_t* msg;
     smx_net_t* producer;
     smx_net_t* consumer;
+    smx_tf_slot_t* slot = ( tt->slots == NULL ) ? NULL
+        : &tt->slots[tt->slot];
+    int count = ( slot == NULL ) ? tt->count : slot->count;
+    int j;
     if( ch_in == NULL || ch_out == NULL )
         return;
 
-    for( i = 0; i < tt->count; i++ ) {
+    // distribute the due pairs round-robin such that shards are balanced
+    for( j = shard; j < count; j += shard_count ) {
+        i = ( slot == NULL ) ? j : slot->pairs[j];
         if( ch_in[i]->source->state == SMX_CHANNEL_UNINITIALISED )
             continue;
         if( ( ( ch_in[i]->fifo->count == 0 )
@@ -214,7 +671,10 @@ void smx_tf_propagate_msgs( smx_net_t* h, int copy )
 
         if( msg != NULL )
         {
-            smx_channel_write( h, ch_out[i], msg );
+            if( !copy && tt->is_handoff != NULL && tt->is_handoff[i] )
+                smx_channel_handoff( h, ch_out[i], msg );
+            else
+                smx_channel_write( h, ch_out[i], msg );
             if( ch_out[i]->fifo->overwrite )
             {
                 // the net that is connected to the source of the output channel
@@ -241,27 +701,307 @@ void smx_tf_propagate_msgs( smx_net_t* h, int copy )
     }
 }
 
+/*****************************************************************************/
+static void smx_tf_record_wakeup( smx_net_t* h, uint64_t deadline )
+{
+    smx_timer_t* timer = h->attr;
+    uint64_t now = smx_time_get_ns();
+    uint64_t lateness = ( now > deadline ) ? now - deadline : 0;
+
+    smx_hist_record( &timer->stats.wakeup, lateness );
+    smx_profiler_log_tf( h, SMX_PROFILER_ACTION_TF_WAKEUP, lateness );
+}
+
+/*****************************************************************************/
+static uint64_t smx_tf_get_deadline( smx_timer_t* timer, uint64_t cycle,
+        int slot )
+{
+    uint64_t deadline = timer->epoch + cycle * timer->hyperperiod;
+    if( timer->slots != NULL )
+        deadline += timer->slots[slot].offset;
+    return deadline;
+}
+
+/*****************************************************************************/
+static uint64_t smx_tf_skip( smx_timer_t* timer, uint64_t now )
+{
+    uint64_t cycle;
+    uint64_t skipped = 0;
+    int slot_count = ( timer->slot_count > 0 ) ? timer->slot_count : 1;
+    int slot;
+
+    // all instants of the hyperperiods before the current one are over
+    cycle = ( now - timer->epoch ) / timer->hyperperiod;
+    if( cycle > timer->cycle + 1 || ( cycle == timer->cycle + 1
+                && timer->slot < slot_count - 1 ) )
+    {
+        skipped = ( cycle - 1 - timer->cycle ) * slot_count
+            + ( slot_count - 1 - timer->slot );
+        timer->cycle = cycle - 1;
+        timer->slot = slot_count - 1;
+    }
+
+    // move to the last instant which is due
+    while( true )
+    {
+        cycle = timer->cycle;
+        slot = timer->slot + 1;
+        if( slot >= slot_count )
+        {
+            slot = 0;
+            cycle++;
+        }
+        if( smx_tf_get_deadline( timer, cycle, slot ) > now )
+            break;
+        timer->cycle = cycle;
+        timer->slot = slot;
+        skipped++;
+    }
+    return skipped;
+}
+
 /*****************************************************************************/
 void smx_tf_wait( smx_net_t* h )
 {
+    int rc;
+    uint64_t now;
     uint64_t expired;
-    struct pollfd pfd;
-    int poll_res;
+    uint64_t deadline;
+    uint64_t skipped;
+    struct itimerspec itval;
     smx_timer_t* timer = h->attr;
     if( h == NULL || timer == NULL )
         return;
 
-    pfd.fd = timer->fd;
-    pfd.events = POLLIN;
-    pfd.revents = 0;
-    poll_res = poll( &pfd, 1, 0 ); // non-blocking poll to check for timer event
-    if( -1 == poll_res )
-        SMX_LOG_NET( h, error, "timerfd poll: %d", errno );
-    else if( poll_res > 0 )
-        SMX_LOG_NET( h, notice, "no wait time, tf timer interval missed: %d", poll_res );
+    if( timer->epoch == 0 )
+        smx_tf_align_epoch( h );
+
+    deadline = smx_tf_get_deadline( timer, timer->cycle, timer->slot );
+    now = smx_time_get_ns();
+    if( deadline <= now )
+    {
+        // the very first instant is due at the epoch
+        if( timer->cycle > 0 || timer->slot > 0 )
+        {
+            // like a timer fd, merge all missed instants into one dispatch
+            skipped = smx_tf_skip( timer, now );
+            deadline = smx_tf_get_deadline( timer, timer->cycle, timer->slot );
+            SMX_LOG_NET( h, notice, "no wait time, tf timer interval missed"
+                    " (%lu instants skipped)", skipped );
+            timer->stats.missed += skipped + 1;
+            smx_profiler_log_tf( h, SMX_PROFILER_ACTION_TF_MISS,
+                    now - deadline );
+        }
+        smx_hist_record( &timer->stats.wakeup, now - deadline );
+        return;
+    }
+
+    if( timer->use_wheel )
+    {
+        if( smx_timer_arm( &timer->tick, deadline, 0 ) < 0 )
+        {
+            SMX_LOG_NET( h, error, "failed to arm tf timer" );
+            return;
+        }
+        pthread_mutex_lock( &timer->mutex );
+        while( timer->ticks == timer->seen )
+            pthread_cond_wait( &timer->cv, &timer->mutex );
+        timer->seen = timer->ticks;
+        pthread_mutex_unlock( &timer->mutex );
+        smx_tf_record_wakeup( h, deadline );
+        return;
+    }
+
+    if( h->sched_dl != NULL )
+    {
+        // the deadline mode releases the firewall without a timer fd
+        smx_time_ns_to_timespec( deadline, &itval.it_value );
+        do {
+            rc = clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME,
+                    &itval.it_value, NULL );
+        } while( rc == EINTR );
+        if( rc != 0 )
+            SMX_LOG_NET( h, error, "clock_nanosleep: %d", rc );
+        smx_tf_record_wakeup( h, deadline );
+        return;
+    }
 
+    smx_time_ns_to_timespec( deadline, &itval.it_value );
+    itval.it_interval.tv_sec = 0;
+    itval.it_interval.tv_nsec = 0;
+    if( -1 == timerfd_settime( timer->fd, TFD_TIMER_ABSTIME, &itval, NULL ) )
+    {
+        SMX_LOG_NET( h, error, "timerfd_settime: %d", errno );
+        return;
+    }
     if( -1 == read( timer->fd, &expired, sizeof( uint64_t ) ) )
         SMX_LOG_NET( h, error, "timerfd read: %d", errno );
+    smx_tf_record_wakeup( h, deadline );
+}
+
+/*****************************************************************************/
+static void smx_tf_advance( smx_timer_t* timer )
+{
+    timer->slot++;
+    if( timer->slot >= timer->slot_count )
+    {
+        timer->slot = 0;
+        timer->cycle++;
+    }
+}
+
+/*****************************************************************************/
+static void* smx_tf_shard_run( void* arg )
+{
+    uint64_t start;
+    uint64_t seen = 0;
+    int shard_count;
+    smx_tf_shard_t* shard = arg;
+    net_smx_tf_state_t* tf_state = shard->state;
+
+    pthread_mutex_lock( &tf_state->mutex );
+    while( true )
+    {
+        while( tf_state->generation == seen )
+            pthread_cond_wait( &tf_state->release_cv, &tf_state->mutex );
+        seen = tf_state->generation;
+        if( !tf_state->is_running )
+            break;
+        shard_count = tf_state->shard_count;
+        pthread_mutex_unlock( &tf_state->mutex );
+
+        start = smx_time_get_ns();
+        smx_tf_propagate_shard( shard->net, tf_state->do_copy, shard->id,
+                shard_count );
+        smx_hist_record( &shard->propagation, smx_time_get_ns() - start );
+
+        pthread_mutex_lock( &tf_state->mutex );
+        tf_state->pending--;
+        if( tf_state->pending == 0 )
+            pthread_cond_signal( &tf_state->join_cv );
+    }
+    pthread_mutex_unlock( &tf_state->mutex );
+    return NULL;
+}
+
+/*****************************************************************************/
+static void smx_tf_propagate_sharded( smx_net_t* h,
+        net_smx_tf_state_t* tf_state )
+{
+    uint64_t start;
+
+    // release all workers at the same instant
+    pthread_mutex_lock( &tf_state->mutex );
+    tf_state->pending = tf_state->shard_count - 1;
+    tf_state->generation++;
+    pthread_cond_broadcast( &tf_state->release_cv );
+    pthread_mutex_unlock( &tf_state->mutex );
+
+    start = smx_time_get_ns();
+    smx_tf_propagate_shard( h, tf_state->do_copy, 0, tf_state->shard_count );
+    smx_hist_record( &tf_state->shards[0].propagation,
+            smx_time_get_ns() - start );
+
+    // all pairs of the instant are propagated before the loop ends
+    pthread_mutex_lock( &tf_state->mutex );
+    while( tf_state->pending > 0 )
+        pthread_cond_wait( &tf_state->join_cv, &tf_state->mutex );
+    pthread_mutex_unlock( &tf_state->mutex );
+}
+
+/*****************************************************************************/
+static int smx_tf_shards_start( smx_net_t* h, net_smx_tf_state_t* tf_state )
+{
+    int i;
+    int count = tf_state->shard_count;
+    int min_fifo, max_fifo;
+    pthread_attr_t attr;
+    struct sched_param param;
+    char name[16];
+
+    tf_state->shards = smx_malloc( sizeof( struct smx_tf_shard_s ) * count );
+    if( tf_state->shards == NULL )
+    {
+        tf_state->shard_count = 1;
+        return -1;
+    }
+
+    tf_state->is_running = true;
+    tf_state->generation = 0;
+    tf_state->pending = 0;
+    pthread_mutex_init( &tf_state->mutex, NULL );
+    pthread_cond_init( &tf_state->release_cv, NULL );
+    pthread_cond_init( &tf_state->join_cv, NULL );
+
+    pthread_attr_init( &attr );
+    if( h->priority > 0 )
+    {
+        min_fifo = sched_get_priority_min( SCHED_FIFO );
+        max_fifo = sched_get_priority_max( SCHED_FIFO );
+        param.sched_priority = min_fifo + h->priority;
+        if( param.sched_priority > max_fifo )
+            param.sched_priority = max_fifo;
+        pthread_attr_setinheritsched( &attr, PTHREAD_EXPLICIT_SCHED );
+        pthread_attr_setschedpolicy( &attr, SCHED_FIFO );
+        pthread_attr_setschedparam( &attr, &param );
+    }
+
+    for( i = 0; i < count; i++ )
+    {
+        tf_state->shards[i].id = i;
+        tf_state->shards[i].net = h;
+        tf_state->shards[i].state = tf_state;
+        smx_hist_init( &tf_state->shards[i].propagation );
+        if( i == 0 )
+            continue;
+
+        errno = pthread_create( &tf_state->shards[i].thread, &attr,
+                smx_tf_shard_run, &tf_state->shards[i] );
+        if( errno != 0 )
+        {
+            SMX_LOG_NET( h, error, "failed to create shard worker %d: %s", i,
+                    strerror( errno ) );
+            // the created workers only see the reduced shard count
+            tf_state->shard_count = i;
+            break;
+        }
+        snprintf( name, sizeof( name ), "smx_tf_%d_%d", h->id, i );
+        pthread_setname_np( tf_state->shards[i].thread, name );
+    }
+    pthread_attr_destroy( &attr );
+
+    SMX_LOG_NET( h, notice, "propagate %d port pairs with %d shards",
+            ( ( smx_timer_t* )h->attr )->count, tf_state->shard_count );
+    return 0;
+}
+
+/*****************************************************************************/
+static void smx_tf_shards_stop( smx_net_t* h, net_smx_tf_state_t* tf_state )
+{
+    int i;
+    char name[64];
+
+    pthread_mutex_lock( &tf_state->mutex );
+    tf_state->is_running = false;
+    tf_state->generation++;
+    pthread_cond_broadcast( &tf_state->release_cv );
+    pthread_mutex_unlock( &tf_state->mutex );
+
+    for( i = 0; i < tf_state->shard_count; i++ )
+    {
+        if( i > 0 )
+            pthread_join( tf_state->shards[i].thread, NULL );
+        if( tf_state->shards[i].propagation.count > 0 )
+        {
+            snprintf( name, sizeof( name ), "tf shard %d propagation time",
+                    i );
+            smx_hist_log( h->cat, name, &tf_state->shards[i].propagation );
+        }
+    }
+    pthread_mutex_destroy( &tf_state->mutex );
+    pthread_cond_destroy( &tf_state->release_cv );
+    pthread_cond_destroy( &tf_state->join_cv );
+    free( tf_state->shards );
 }
 
 /**
@@ -278,20 +1018,51 @@ void smx_tf_wait( smx_net_t* h )
  */
 int smx_tf( void* h, void* state )
 {
+    uint64_t start;
+    uint64_t duration;
     net_smx_tf_state_t* tf_state = state;
-    smx_tf_propagate_msgs( h, tf_state->do_copy );
-    SMX_LOG_NET( h, debug, "wait for end of loop" );
+    smx_timer_t* timer = ( ( smx_net_t* )h )->attr;
+    SMX_LOG_NET( h, debug, "wait for next dispatch instant" );
     smx_tf_wait( h );
+    start = smx_time_get_ns();
+    if( tf_state->shards != NULL )
+        smx_tf_propagate_sharded( h, tf_state );
+    else
+        smx_tf_propagate_msgs( h, tf_state->do_copy );
+    duration = smx_time_get_ns() - start;
+    smx_hist_record( &timer->stats.propagation, duration );
+    smx_profiler_log_tf( h, SMX_PROFILER_ACTION_TF_PROPAGATE, duration );
+    timer->stats.dispatches++;
+    smx_tf_advance( timer );
     return SMX_NET_RETURN;
 }
 
 /*****************************************************************************/
 void smx_tf_cleanup( void* h, void* state )
 {
-    ( void )( h );
+    smx_net_t* net = h;
+    smx_timer_t* timer = ( net != NULL ) ? net->attr : NULL;
+    net_smx_tf_state_t* tf_state;
+
+    if( timer != NULL )
+    {
+        SMX_LOG_NET( net, notice, "tf dispatched %lu instants, missed %lu",
+                timer->stats.dispatches, timer->stats.missed );
+        if( timer->stats.dispatches > 0 )
+        {
+            smx_hist_log( net->cat, "tf wake-up lateness",
+                    &timer->stats.wakeup );
+            smx_hist_log( net->cat, "tf propagation time",
+                    &timer->stats.propagation );
+        }
+    }
+
     if( state == NULL)
         return;
 
+    tf_state = state;
+    if( tf_state->shards != NULL )
+        smx_tf_shards_stop( net, tf_state );
     free( state );
 }
 
@@ -308,9 +1079,18 @@ int smx_tf_init( void* h, void** state )
     }
 
     tf_state = smx_malloc( sizeof( struct net_smx_tf_state_s ) );
+    if( tf_state == NULL )
+        return -1;
     tf_state->do_copy = smx_config_get_bool( SMX_NET_GET_CONF( h ), "copy" );
     SMX_LOG_NET( h, notice, "setting proprty 'copy' to '%d'", tf_state->do_copy );
-
+    tf_state->shard_count = 1;
+    tf_state->shards = NULL;
+    smx_config_init_int( SMX_NET_GET_CONF( h ), "shards",
+            &tf_state->shard_count );
+    if( tf_state->shard_count > tt->count )
+        tf_state->shard_count = tt->count;
+    if( tf_state->shard_count > 1 )
+        smx_tf_shards_start( h, tf_state );
 
     SMX_LOG_NET( h, notice, "start net" );
     smx_tf_enable( h );
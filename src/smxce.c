@@ -0,0 +1,463 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @author  Simon Maurer
+ *
+ * The cyclic executive of the runtime system library of Streamix.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <urcu.h>
+#include "smxce.h"
+#include "smxlog.h"
+#include "smxnet.h"
+#include "smxprofiler.h"
+#include "smxstats.h"
+#include "smxutils.h"
+
+/**
+ * The maximal number of releases within one hyperperiod. Beyond this the
+ * schedule table would get too large and all nets run at the fastest rate.
+ */
+#define SMX_CE_MAX_JOBS 4096
+
+/*****************************************************************************/
+static uint64_t smx_ce_gcd( uint64_t a, uint64_t b )
+{
+    uint64_t tmp;
+    while( b != 0 )
+    {
+        tmp = a % b;
+        a = b;
+        b = tmp;
+    }
+    return a;
+}
+
+/*****************************************************************************/
+static int smx_ce_job_cmp( const void* a, const void* b )
+{
+    const smx_ce_job_t* job_a = a;
+    const smx_ce_job_t* job_b = b;
+
+    if( job_a->offset != job_b->offset )
+        return ( job_a->offset < job_b->offset ) ? -1 : 1;
+    // releases at the same offset run in the order of their priority
+    if( job_a->priority != job_b->priority )
+        return ( job_a->priority > job_b->priority ) ? -1 : 1;
+    return job_a->member - job_b->member;
+}
+
+/*****************************************************************************/
+static int smx_ce_schedule( smx_ce_t* ce )
+{
+    int i;
+    int j;
+    uint64_t k;
+    uint64_t t = 0;
+    uint64_t job_cnt = 0;
+    uint64_t hyperperiod = 1;
+    uint64_t min_period = UINT64_MAX;
+    double utilisation = 0;
+    bool is_bounded = true;
+    smx_ce_member_t* member;
+
+    for( i = 0; i < ce->count; i++ )
+    {
+        member = &ce->members[i];
+        if( member->period < min_period )
+            min_period = member->period;
+        if( is_bounded )
+        {
+            hyperperiod = hyperperiod / smx_ce_gcd( hyperperiod,
+                    member->period );
+            if( hyperperiod > UINT64_MAX / member->period )
+                is_bounded = false;
+            else
+                hyperperiod *= member->period;
+        }
+        if( member->wcet > 0 )
+            utilisation += ( double )member->wcet / member->period;
+    }
+    for( i = 0; is_bounded && i < ce->count; i++ )
+    {
+        job_cnt += hyperperiod / ce->members[i].period;
+        if( job_cnt > SMX_CE_MAX_JOBS )
+            is_bounded = false;
+    }
+    if( !is_bounded )
+    {
+        SMX_LOG_MAIN( main, error, "cyclic executive on core %d: hyperperiod"
+                " too large for a schedule table, all nets run every %lu ns",
+                ce->core, min_period );
+        hyperperiod = min_period;
+        job_cnt = ce->count;
+        for( i = 0; i < ce->count; i++ )
+            ce->members[i].period = min_period;
+    }
+
+    ce->jobs = smx_malloc( sizeof( struct smx_ce_job_s ) * job_cnt );
+    if( ce->jobs == NULL )
+        return -1;
+    for( i = 0, j = 0; i < ce->count; i++ )
+    {
+        for( k = 0; k < hyperperiod; k += ce->members[i].period )
+        {
+            ce->jobs[j].offset = k;
+            ce->jobs[j].member = i;
+            ce->jobs[j].priority = ce->members[i].net->priority;
+            j++;
+        }
+    }
+    qsort( ce->jobs, job_cnt, sizeof( struct smx_ce_job_s ), smx_ce_job_cmp );
+    ce->job_count = job_cnt;
+    ce->hyperperiod = hyperperiod;
+
+    // check the table with the budgets, jobs are not preempted
+    for( j = 0; j < ce->job_count; j++ )
+    {
+        member = &ce->members[ce->jobs[j].member];
+        if( t < ce->jobs[j].offset )
+            t = ce->jobs[j].offset;
+        t += member->wcet;
+        if( member->wcet > 0 && t > ce->jobs[j].offset + member->period )
+        {
+            SMX_LOG_NET( member->net, warn, "cyclic executive schedule is"
+                    " infeasible: release at %lu ns finishes at %lu ns",
+                    ce->jobs[j].offset, t );
+        }
+    }
+
+    SMX_LOG_MAIN( main, notice, "cyclic executive on core %d: %d nets,"
+            " hyperperiod %lu ns, %d releases, budget utilisation %.2f",
+            ce->core, ce->count, ce->hyperperiod, ce->job_count, utilisation );
+    return 0;
+}
+
+/*****************************************************************************/
+static void smx_ce_execute( smx_ce_t* ce, smx_ce_member_t* member,
+        uint64_t release )
+{
+    int state;
+    uint64_t start, end;
+    smx_net_t* net = member->net;
+
+    smx_profiler_log_net( net, SMX_PROFILER_ACTION_NET_START );
+    net->count++;
+    SMX_LOG_NET( net, info, "start net loop %ld", net->count );
+    smx_profiler_log_net( net, SMX_PROFILER_ACTION_NET_START_IMPL );
+    start = smx_time_get_ns();
+    state = member->impl( net, net->state );
+    end = smx_time_get_ns();
+    smx_profiler_log_net( net, SMX_PROFILER_ACTION_NET_END_IMPL );
+    smx_hist_record( &net->stats->await, start - release );
+    smx_hist_record( &net->stats->impl, end - start );
+    smx_hist_record( &net->stats->loop, end - release );
+
+    member->jobs++;
+    if( end - start > member->exec_max )
+        member->exec_max = end - start;
+    if( member->wcet > 0 && end - start > member->wcet )
+    {
+        member->overruns++;
+        SMX_LOG_NET( net, warn, "overrun: impl took %lu ns, budget is %lu ns",
+                end - start, member->wcet );
+    }
+    if( end > release + member->period )
+    {
+        member->misses++;
+        SMX_LOG_NET( net, warn, "deadline miss: finished %lu ns after"
+                " release", end - release );
+    }
+
+    state = smx_net_update_state( net, state );
+    smx_profiler_log_net( net, SMX_PROFILER_ACTION_NET_END );
+    if( state == SMX_NET_END )
+    {
+        pthread_mutex_lock( &ce->mutex );
+        member->is_done = true;
+        ce->active--;
+        pthread_cond_broadcast( &ce->cv );
+        pthread_mutex_unlock( &ce->mutex );
+    }
+}
+
+/*****************************************************************************/
+static void* smx_ce_run( void* arg )
+{
+    int i;
+    int j;
+    int rc;
+    uint64_t epoch;
+    uint64_t release;
+    struct timespec ts;
+    smx_ce_t* ce = arg;
+    smx_ce_member_t* member;
+
+    rcu_register_thread();
+    SMX_LOG_MAIN( main, notice, "start cyclic executive on core %d",
+            ce->core );
+    if( smx_ce_schedule( ce ) < 0 )
+    {
+        pthread_mutex_lock( &ce->mutex );
+        for( i = 0; i < ce->count; i++ )
+            ce->members[i].is_done = true;
+        ce->active = 0;
+        pthread_cond_broadcast( &ce->cv );
+        pthread_mutex_unlock( &ce->mutex );
+        goto end;
+    }
+
+    epoch = smx_time_get_ns();
+    while( ce->active > 0 )
+    {
+        for( j = 0; j < ce->job_count; j++ )
+        {
+            member = &ce->members[ce->jobs[j].member];
+            if( member->is_done )
+                continue;
+            release = epoch + ce->cycles * ce->hyperperiod
+                + ce->jobs[j].offset;
+            if( smx_time_get_ns() < release )
+            {
+                smx_time_ns_to_timespec( release, &ts );
+                do {
+                    rc = clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME,
+                            &ts, NULL );
+                } while( rc == EINTR );
+            }
+            smx_ce_execute( ce, member, release );
+        }
+        ce->cycles++;
+    }
+
+    for( i = 0; i < ce->count; i++ )
+    {
+        member = &ce->members[i];
+        SMX_LOG_NET( member->net, notice, "cyclic executive: %lu releases,"
+                " %lu overruns, %lu deadline misses, max impl time %lu ns"
+                " (budget: %lu ns)", member->jobs, member->overruns,
+                member->misses, member->exec_max, member->wcet );
+    }
+
+end:
+    SMX_LOG_MAIN( main, notice, "terminate cyclic executive on core %d"
+            " (cycles: %lu)", ce->core, ce->cycles );
+    rcu_unregister_thread();
+    return NULL;
+}
+
+/*****************************************************************************/
+static void smx_ce_start( smx_ce_t* ce )
+{
+    int i;
+    int prio = 0;
+    int max_fifo;
+    cpu_set_t cpus;
+    pthread_attr_t attr;
+    struct sched_param param;
+
+    if( ce->is_started || ce->count == 0 || ce->count < ce->expected )
+        return;
+
+    for( i = 0; i < ce->count; i++ )
+    {
+        if( ce->members[i].net->priority > prio )
+            prio = ce->members[i].net->priority;
+    }
+
+    pthread_attr_init( &attr );
+    CPU_ZERO( &cpus );
+    CPU_SET( ce->core, &cpus );
+    pthread_attr_setaffinity_np( &attr, sizeof( cpus ), &cpus );
+    if( prio > 0 )
+    {
+        max_fifo = sched_get_priority_max( SCHED_FIFO );
+        param.sched_priority = sched_get_priority_min( SCHED_FIFO ) + prio;
+        if( param.sched_priority > max_fifo )
+            param.sched_priority = max_fifo;
+        pthread_attr_setinheritsched( &attr, PTHREAD_EXPLICIT_SCHED );
+        pthread_attr_setschedpolicy( &attr, SCHED_FIFO );
+        pthread_attr_setschedparam( &attr, &param );
+    }
+
+    ce->active = ce->count;
+    errno = pthread_create( &ce->thread, &attr, smx_ce_run, ce );
+    pthread_attr_destroy( &attr );
+    if( errno != 0 )
+    {
+        SMX_LOG_MAIN( main, error, "failed to start cyclic executive on core"
+                " %d: %s", ce->core, strerror( errno ) );
+        for( i = 0; i < ce->count; i++ )
+            ce->members[i].is_done = true;
+        ce->active = 0;
+        pthread_cond_broadcast( &ce->cv );
+        return;
+    }
+    ce->is_started = true;
+}
+
+/*****************************************************************************/
+smx_ce_t* smx_ce_assign( smx_rts_t* rts, int core )
+{
+    smx_ce_t* ce;
+
+    // the net mutex may be held by the caller when a net is created at runtime
+    pthread_mutex_lock( &rts->ce_mutex );
+    for( ce = rts->ce; ce != NULL; ce = ce->next )
+    {
+        if( ce->core == core )
+            break;
+    }
+    if( ce == NULL )
+    {
+        ce = smx_malloc( sizeof( struct smx_ce_s ) );
+        if( ce == NULL )
+            goto end;
+
+        ce->core = core;
+        ce->expected = 0;
+        ce->count = 0;
+        ce->active = 0;
+        ce->members = NULL;
+        ce->jobs = NULL;
+        ce->job_count = 0;
+        ce->hyperperiod = 0;
+        ce->cycles = 0;
+        ce->is_started = false;
+        pthread_mutex_init( &ce->mutex, NULL );
+        pthread_cond_init( &ce->cv, NULL );
+        ce->next = rts->ce;
+        rts->ce = ce;
+    }
+
+    pthread_mutex_lock( &ce->mutex );
+    if( ce->is_started )
+    {
+        // the schedule table of a running executive is static
+        SMX_LOG_MAIN( main, warn, "cyclic executive on core %d is already"
+                " running, net is executed in its own thread", core );
+        pthread_mutex_unlock( &ce->mutex );
+        ce = NULL;
+        goto end;
+    }
+    ce->expected++;
+    pthread_mutex_unlock( &ce->mutex );
+
+end:
+    pthread_mutex_unlock( &rts->ce_mutex );
+    return ce;
+}
+
+/*****************************************************************************/
+bool smx_ce_is_capable( smx_net_t* net )
+{
+    int i;
+    smx_channel_t* ch;
+
+    if( net->sig->source.count > 0 )
+        return false;
+
+    for( i = 0; i < net->sig->in.count; i++ )
+    {
+        ch = net->sig->in.ports[i];
+        if( ch != NULL && ch->type != SMX_FIFO_D && ch->type != SMX_D_FIFO_D )
+            return false;
+    }
+    for( i = 0; i < net->sig->out.count; i++ )
+    {
+        ch = net->sig->out.ports[i];
+        if( ch != NULL && ch->type != SMX_D_FIFO && ch->type != SMX_D_FIFO_D )
+            return false;
+    }
+    return true;
+}
+
+/*****************************************************************************/
+void smx_ce_destroy( smx_rts_t* rts )
+{
+    smx_ce_t* ce;
+
+    while( rts->ce != NULL )
+    {
+        ce = rts->ce;
+        rts->ce = ce->next;
+        if( ce->is_started )
+            pthread_join( ce->thread, NULL );
+        pthread_mutex_destroy( &ce->mutex );
+        pthread_cond_destroy( &ce->cv );
+        free( ce->members );
+        free( ce->jobs );
+        free( ce );
+    }
+}
+
+/*****************************************************************************/
+int smx_ce_join( smx_ce_t* ce, smx_net_t* net, int impl( void*, void* ) )
+{
+    int idx;
+    smx_ce_member_t* members;
+
+    pthread_mutex_lock( &ce->mutex );
+    if( ce->is_started )
+    {
+        // the executive reads the members without a lock once started
+        SMX_LOG_NET( net, error, "cyclic executive on core %d is already"
+                " running", ce->core );
+        pthread_mutex_unlock( &ce->mutex );
+        return -1;
+    }
+    members = realloc( ce->members,
+            sizeof( struct smx_ce_member_s ) * ( ce->count + 1 ) );
+    if( members == NULL )
+    {
+        SMX_LOG_NET( net, error, "failed to join cyclic executive" );
+        ce->expected--;
+        smx_ce_start( ce );
+        pthread_mutex_unlock( &ce->mutex );
+        return -1;
+    }
+    ce->members = members;
+    idx = ce->count;
+    members[idx].net = net;
+    members[idx].impl = impl;
+    members[idx].period = SMX_NSEC_PER_SEC / net->expected_rate;
+    members[idx].wcet = net->wcet;
+    members[idx].exec_max = 0;
+    members[idx].jobs = 0;
+    members[idx].overruns = 0;
+    members[idx].misses = 0;
+    members[idx].is_done = false;
+    ce->count++;
+    SMX_LOG_NET( net, notice, "join cyclic executive on core %d (period: %lu"
+            " ns)", ce->core, members[idx].period );
+    smx_ce_start( ce );
+
+    while( !ce->members[idx].is_done )
+        pthread_cond_wait( &ce->cv, &ce->mutex );
+    pthread_mutex_unlock( &ce->mutex );
+    return 0;
+}
+
+/*****************************************************************************/
+void smx_ce_leave( smx_ce_t* ce, smx_net_t* net )
+{
+    int i;
+
+    pthread_mutex_lock( &ce->mutex );
+    for( i = 0; i < ce->count; i++ )
+    {
+        if( ce->members[i].net == net )
+        {
+            pthread_mutex_unlock( &ce->mutex );
+            return;
+        }
+    }
+    ce->expected--;
+    smx_ce_start( ce );
+    pthread_mutex_unlock( &ce->mutex );
+}
@@ -9,20 +9,22 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
-#include <sys/timerfd.h>
-#include <unistd.h>
 #include "smxch.h"
 #include "smxmsg.h"
+#include "smxnet.h"
 #include "smxutils.h"
 #include "smxlog.h"
 #include "smxprofiler.h"
+#include "smxtimer.h"
 
 /*****************************************************************************/
-int smx_channel_await( void *h, smx_channel_t* ch )
+static int smx_channel_await_until( void *h, smx_channel_t* ch,
+        bool stop_on_update )
 {
     int rc = 0;
-    struct timespec ts;
-    int nsec_sum;
+    bool has_timeout;
+    struct timespec deadline;
+    smx_net_t* net = h;
 
     if( ch == NULL )
     {
@@ -43,33 +45,33 @@ int smx_channel_await( void *h, smx_channel_t* ch )
     }
 
     ch->source->err = SMX_CHANNEL_ERR_NONE;
+    has_timeout = ( ch->source->timeout.tv_sec != 0
+            || ch->source->timeout.tv_nsec != 0 );
+    if( has_timeout )
+    {
+        // one deadline for the whole operation, spurious wakeups don't extend it
+        smx_time_get_deadline( &ch->source->timeout, &deadline );
+    }
 
     pthread_mutex_lock( &ch->ch_mutex);
     while( ch->source->state == SMX_CHANNEL_PENDING && rc == 0 )
     {
+        if( stop_on_update && net != NULL && smx_net_has_updates( net ) )
+        {
+            // return to the net loop to apply the pending updates
+            break;
+        }
         smx_profiler_log_ch( h, ch, NULL, SMX_PROFILER_ACTION_CH_READ_BLOCK,
                 ch->fifo->count );
         SMX_LOG_CH( ch, debug, "waiting for message" );
-        if( ch->source->timeout.tv_sec == 0
-                && ch->source->timeout.tv_nsec == 0 )
+        if( !has_timeout )
         {
             rc = pthread_cond_wait( &ch->source->ch_cv, &ch->ch_mutex );
         }
         else
         {
-            clock_gettime( CLOCK_REALTIME, &ts );
-            ts.tv_sec += ch->source->timeout.tv_sec;
-            nsec_sum = ts.tv_nsec + ch->source->timeout.tv_nsec;
-            if( nsec_sum > 1000000000 )
-            {
-                ts.tv_sec++;
-                nsec_sum -= 1000000000;
-            }
-            ts.tv_nsec = nsec_sum;
-            SMX_LOG_CH( ch, debug, "wait timeout set to %ld, %ld",
-                    ch->source->timeout.tv_sec, ch->source->timeout.tv_nsec );
             rc = pthread_cond_timedwait( &ch->source->ch_cv,
-                    &ch->ch_mutex, &ts );
+                    &ch->ch_mutex, &deadline );
         }
         if( rc == ETIMEDOUT )
         {
@@ -93,6 +95,18 @@ int smx_channel_await( void *h, smx_channel_t* ch )
     return SMX_CHANNEL_ERR_NONE;
 }
 
+/*****************************************************************************/
+int smx_channel_await( void *h, smx_channel_t* ch )
+{
+    return smx_channel_await_until( h, ch, false );
+}
+
+/*****************************************************************************/
+int smx_channel_await_update( void *h, smx_channel_t* ch )
+{
+    return smx_channel_await_until( h, ch, true );
+}
+
 /*****************************************************************************/
 smx_msg_t* smx_channel_await_and_read( void *h, smx_channel_t* ch )
 {
@@ -168,11 +182,6 @@ smx_channel_t* smx_channel_create( int* ch_cnt, int len,
         const char* cat_name )
 {
     pthread_mutexattr_t mutexattr_prioinherit;
-    if( id >= SMX_MAX_CHS )
-    {
-        SMX_LOG_MAIN( main, fatal, "channel count exeeds maximum %d", id );
-        return NULL;
-    }
     smx_channel_t* ch = smx_malloc( sizeof( struct smx_channel_s ) );
     if( ch == NULL )
         return NULL;
@@ -205,13 +214,14 @@ smx_channel_t* smx_channel_create( int* ch_cnt, int len,
         smx_channel_destroy( ch );
         return NULL;
     }
-    (*ch_cnt)++;
+    __atomic_add_fetch( ch_cnt, 1, __ATOMIC_RELAXED );
     return ch;
 }
 
 /*****************************************************************************/
 smx_channel_end_t* smx_channel_create_end()
 {
+    pthread_condattr_t attr;
     smx_channel_end_t* end = smx_malloc( sizeof( struct smx_channel_end_s ) );
     if( end == NULL )
         return NULL;
@@ -224,7 +234,11 @@ smx_channel_end_t* smx_channel_create_end()
     end->content_filter = NULL;
     end->timeout.tv_sec = 0;
     end->timeout.tv_nsec = 0;
-    pthread_cond_init( &end->ch_cv, NULL );
+    // timed waits use absolute deadlines which must not follow clock steps
+    pthread_condattr_init( &attr );
+    pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+    pthread_cond_init( &end->ch_cv, &attr );
+    pthread_condattr_destroy( &attr );
     return end;
 }
 
@@ -276,6 +290,9 @@ smx_msg_t* smx_channel_read( void* h, smx_channel_t* ch )
 smx_msg_t* smx_channel_read_rts( void* h, smx_channel_t* ch )
 {
     smx_msg_t* msg = NULL;
+    int rc = 0;
+    smx_channel_state_t state;
+    struct timespec deadline;
     if( ch == NULL )
     {
         return NULL;
@@ -299,20 +316,33 @@ smx_msg_t* smx_channel_read_rts( void* h, smx_channel_t* ch )
 
     if( ch->source->state == SMX_CHANNEL_UNINITIALISED )
     {
-        // decoupled channel has not yet received any data
-        ch->source->err = SMX_CHANNEL_ERR_UNINITIALISED;
-        if( ch->source->timeout.tv_sec > 0 )
+        // decoupled channel has not yet received any data, wait for the first
+        // write until the timeout expires
+        pthread_mutex_lock( &ch->ch_mutex );
+        if( ch->source->timeout.tv_sec != 0
+                || ch->source->timeout.tv_nsec != 0 )
         {
-            sleep( ch->source->timeout.tv_sec );
-            ch->source->err = SMX_CHANNEL_ERR_TIMEOUT;
+            smx_time_get_deadline( &ch->source->timeout, &deadline );
+            while( ch->source->state == SMX_CHANNEL_UNINITIALISED && rc == 0 )
+            {
+                rc = pthread_cond_timedwait( &ch->source->ch_cv,
+                        &ch->ch_mutex, &deadline );
+            }
         }
-        if( ch->source->timeout.tv_nsec > 0 )
+        state = ch->source->state;
+        pthread_mutex_unlock( &ch->ch_mutex );
+        if( state == SMX_CHANNEL_UNINITIALISED )
         {
-            usleep( ch->source->timeout.tv_nsec / 1000 );
-            ch->source->err = SMX_CHANNEL_ERR_TIMEOUT;
+            if( rc == ETIMEDOUT )
+                ch->source->err = SMX_CHANNEL_ERR_TIMEOUT;
+            else if( rc != 0 )
+                ch->source->err = SMX_CHANNEL_ERR_CV;
+            else
+                ch->source->err = SMX_CHANNEL_ERR_UNINITIALISED;
+            return NULL;
         }
-        return NULL;
-    } else if( ch->source->state != SMX_CHANNEL_READY
+    }
+    if( ch->source->state != SMX_CHANNEL_READY
             && ch->source->state != SMX_CHANNEL_END )
     {
         // await before main loop timed out
@@ -525,13 +555,13 @@ int smx_channel_write( void* h, smx_channel_t* ch, smx_msg_t* msg )
 int smx_channel_write_rts( void* h, smx_channel_t* ch, smx_msg_t* msg )
 {
     int rc = 0;
-    int nsec_sum;
     bool abort = false;
+    bool has_timeout;
     int new_count;
     int i;
     const char* filter;
     bool pass = false;
-    struct timespec ts;
+    struct timespec deadline;
 
     if( ch == NULL )
     {
@@ -595,31 +625,27 @@ int smx_channel_write_rts( void* h, smx_channel_t* ch, smx_msg_t* msg )
         return 0;
     }
 
+    has_timeout = ( ch->sink->timeout.tv_sec != 0
+            || ch->sink->timeout.tv_nsec != 0 );
+    if( has_timeout )
+    {
+        smx_time_get_deadline( &ch->sink->timeout, &deadline );
+    }
+
     pthread_mutex_lock( &ch->ch_mutex );
     while( ch->sink->state == SMX_CHANNEL_PENDING && rc == 0 )
     {
         smx_profiler_log_ch( h, ch, msg, SMX_PROFILER_ACTION_CH_WRITE_BLOCK,
                 ch->fifo->count );
         SMX_LOG_CH( ch, debug, "waiting for free space" );
-        if( ch->sink->timeout.tv_sec == 0 && ch->sink->timeout.tv_nsec == 0 )
+        if( !has_timeout )
         {
             rc = pthread_cond_wait( &ch->sink->ch_cv, &ch->ch_mutex );
         }
         else
         {
-            clock_gettime( CLOCK_REALTIME, &ts );
-            ts.tv_sec += ch->sink->timeout.tv_sec;
-            nsec_sum = ts.tv_nsec + ch->sink->timeout.tv_nsec;
-            if( nsec_sum > 1000000000 )
-            {
-                ts.tv_sec++;
-                nsec_sum -= 1000000000;
-            }
-            ts.tv_nsec = nsec_sum;
-            SMX_LOG_CH( ch, debug, "wait timeout set to %ld, %ld",
-                    ch->sink->timeout.tv_sec, ch->sink->timeout.tv_nsec );
             rc = pthread_cond_timedwait( &ch->sink->ch_cv,
-                    &ch->ch_mutex, &ts );
+                    &ch->ch_mutex, &deadline );
         }
         if( rc == ETIMEDOUT )
         {
@@ -703,6 +729,71 @@ int smx_channel_write_rts( void* h, smx_channel_t* ch, smx_msg_t* msg )
     return 0;
 }
 
+/*****************************************************************************/
+static smx_msg_t* smx_d_fifo_swap( smx_fifo_t* fifo, smx_msg_t* msg )
+{
+    smx_msg_t* msg_tmp = NULL;
+
+    if( fifo->count < fifo->length )
+    {
+        fifo->tail->msg = msg;
+        fifo->tail = fifo->tail->prev;
+        fifo->count++;
+        fifo->overwrite = 0;
+    }
+    else
+    {
+        msg_tmp = fifo->tail->msg;
+        fifo->tail->msg = msg;
+        fifo->overwrite++;
+    }
+    return msg_tmp;
+}
+
+/*****************************************************************************/
+int smx_channel_handoff( void* h, smx_channel_t* ch, smx_msg_t* msg )
+{
+    smx_msg_t* msg_tmp;
+
+    pthread_mutex_lock( &ch->ch_mutex );
+    if( ch->sink->state == SMX_CHANNEL_END )
+    {
+        pthread_mutex_unlock( &ch->ch_mutex );
+        smx_msg_destroy( h, msg, true );
+        return -1;
+    }
+    msg_tmp = smx_d_fifo_swap( ch->fifo, msg );
+    if( msg_tmp != NULL )
+    {
+        smx_profiler_log_ch( h, ch, msg, SMX_PROFILER_ACTION_CH_OVERWRITE,
+                ch->fifo->length );
+    }
+    // notify consumer that messages are available
+    smx_channel_change_read_state( ch, SMX_CHANNEL_READY );
+    smx_profiler_log_ch( h, ch, msg, SMX_PROFILER_ACTION_CH_WRITE,
+            ch->fifo->count );
+    SMX_LOG_CH( ch, info, "handoff to d_fifo (new count: %d)",
+            ch->fifo->count );
+    pthread_mutex_unlock( &ch->ch_mutex );
+
+    smx_msg_destroy( h, msg_tmp, true );
+    return 0;
+}
+
+/*****************************************************************************/
+bool smx_channel_is_handoff_capable( smx_channel_t* ch )
+{
+    if( ch == NULL || ch->sink == NULL || ch->sink->net == NULL
+            || ch->fifo == NULL )
+        return false;
+
+    return ( ch->type == SMX_D_FIFO || ch->type == SMX_D_FIFO_D )
+        && ch->sink->filter.items == NULL
+        && ch->sink->content_filter == NULL
+        && ch->guard == NULL
+        && ch->collector == NULL;
+}
+
 /*****************************************************************************/
 smx_collector_t* smx_collector_create()
 {
@@ -742,15 +833,12 @@ void smx_collector_terminate( smx_channel_t* ch )
     ch->collector->ch_count--;
     zlog_debug( ch->cat, "input channel has terminated, new count: %d",
             ch->collector->ch_count );
-    pthread_mutex_unlock( &ch->collector->col_mutex );
-
     if( ch->collector->ch_count == 0 )
     {
         zlog_debug( ch->cat, "mark collector as stale" );
-        pthread_mutex_lock( &ch->collector->col_mutex );
         smx_channel_change_collector_state( ch, SMX_CHANNEL_END );
-        pthread_mutex_unlock( &ch->collector->col_mutex );
     }
+    pthread_mutex_unlock( &ch->collector->col_mutex );
 }
 
 /*****************************************************************************/
@@ -1105,7 +1193,6 @@ smx_channel_err_t smx_get_write_error( smx_channel_t* ch )
 /*****************************************************************************/
 smx_guard_t* smx_guard_create( int iats, int iatns, smx_channel_t* ch )
 {
-    struct itimerspec itval;
     SMX_LOG_CH( ch, debug, "create guard" );
     smx_guard_t* guard = smx_malloc( sizeof( struct smx_guard_s ) );
     if( guard == NULL ) 
@@ -1113,25 +1200,11 @@ smx_guard_t* smx_guard_create( int iats, int iatns, smx_channel_t* ch )
 
     guard->iat.tv_sec = iats;
     guard->iat.tv_nsec = iatns;
-    itval.it_value.tv_sec = 0;
-    itval.it_value.tv_nsec = 1; // arm timer to immediately fire (1ns delay)
-    itval.it_interval.tv_sec = 0;
-    itval.it_interval.tv_nsec = 0;
-    guard->fd = timerfd_create( CLOCK_MONOTONIC, 0 );
-    if( guard->fd == -1 )
-    {
-        SMX_LOG_CH( ch, error, "failed to create guard timer \
-                (timerfd_create returned %d", errno );
-        free( guard );
-        return NULL;
-    }
-    if( -1 == timerfd_settime( guard->fd, 0, &itval, NULL ) )
-    {
-        SMX_LOG_CH( ch, error, "failed to arm guard timer \
-                (timerfd_settime returned %d)", errno );
-        free( guard );
-        return NULL;
-    }
+    // the first message may pass immediately
+    guard->is_expired = true;
+    pthread_mutex_init( &guard->mutex, NULL );
+    pthread_cond_init( &guard->cv, NULL );
+    smx_timer_init( &guard->timer, smx_guard_expire, guard );
     return guard;
 }
 
@@ -1139,51 +1212,63 @@ smx_guard_t* smx_guard_create( int iats, int iatns, smx_channel_t* ch )
 void smx_guard_destroy( smx_guard_t* guard )
 {
     if( guard == NULL ) return;
-    close( guard->fd );
+    smx_timer_cancel( &guard->timer );
+    pthread_mutex_destroy( &guard->mutex );
+    pthread_cond_destroy( &guard->cv );
     free( guard );
 }
 
+/*****************************************************************************/
+void smx_guard_expire( void* arg )
+{
+    smx_guard_t* guard = arg;
+    pthread_mutex_lock( &guard->mutex );
+    guard->is_expired = true;
+    pthread_cond_signal( &guard->cv );
+    pthread_mutex_unlock( &guard->mutex );
+}
+
+/*****************************************************************************/
+static int smx_guard_rearm( smx_channel_t* ch )
+{
+    if( smx_timer_arm( &ch->guard->timer, smx_time_get_ns()
+                + smx_time_timespec_to_ns( &ch->guard->iat ), 0 ) < 0 )
+    {
+        SMX_LOG_CH( ch, error, "failed to re-arm guard timer" );
+        return -1;
+    }
+    return 0;
+}
+
 /*****************************************************************************/
 int smx_guard_write( void* h, smx_channel_t* ch )
 {
-    uint64_t expired;
-    struct itimerspec itval;
     (void)(h);
     if( ch == NULL || ch->guard == NULL )
         return -1;
 
-    if( -1 == read( ch->guard->fd, &expired, sizeof( uint64_t ) ) )
+    pthread_mutex_lock( &ch->guard->mutex );
+    while( !ch->guard->is_expired )
     {
-        SMX_LOG_CH( ch, error, "falied to read guard timer \
-                (read returned %d", errno );
-        return -1;
+        pthread_cond_wait( &ch->guard->cv, &ch->guard->mutex );
     }
-    itval.it_value = ch->guard->iat;
-    itval.it_interval.tv_sec = 0;
-    itval.it_interval.tv_nsec = 0;
-    if( -1 == timerfd_settime( ch->guard->fd, 0, &itval, NULL ) )
-    {
-        SMX_LOG_CH( ch, error, "failed to re-arm guard timer \
-                (timerfd_settime retuned %d", errno );
-        return -1;
-    }
-    return 0;
+    ch->guard->is_expired = false;
+    pthread_mutex_unlock( &ch->guard->mutex );
+    return smx_guard_rearm( ch );
 }
 
 /*****************************************************************************/
 int smx_d_guard_write( void* h, smx_channel_t* ch, smx_msg_t* msg )
 {
-    struct itimerspec itval;
+    bool is_expired;
     if( ch == NULL || ch->guard == NULL )
         return -1;
 
-    if( -1 == timerfd_gettime( ch->guard->fd, &itval ) )
-    {
-        SMX_LOG_CH( ch, error, "falied to read guard timer \
-                (timerfd_gettime returned %d", errno );
-        return -1;
-    }
-    if( ( itval.it_value.tv_sec != 0 ) || ( itval.it_value.tv_nsec != 0 ) ) {
+    pthread_mutex_lock( &ch->guard->mutex );
+    is_expired = ch->guard->is_expired;
+    ch->guard->is_expired = false;
+    pthread_mutex_unlock( &ch->guard->mutex );
+    if( !is_expired ) {
         SMX_LOG_CH( ch, info, "rate_control: discard message '%llu'",
                 msg->id );
         smx_profiler_log_ch( h, ch, msg, SMX_PROFILER_ACTION_CH_DISMISS,
@@ -1191,16 +1276,7 @@ int smx_d_guard_write( void* h, smx_channel_t* ch, smx_msg_t* msg )
         smx_msg_destroy( h, msg, true );
         return 1;
     }
-    itval.it_value = ch->guard->iat;
-    itval.it_interval.tv_sec = 0;
-    itval.it_interval.tv_nsec = 0;
-    if( -1 == timerfd_settime( ch->guard->fd, 0, &itval, NULL ) )
-    {
-        SMX_LOG_CH( ch, error, "failed to re-arm guard timer \
-                (timerfd_settime retuned %d", errno );
-        return -1;
-    }
-    return 0;
+    return smx_guard_rearm( ch );
 }
 
 /*****************************************************************************/
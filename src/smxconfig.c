@@ -6,8 +6,10 @@
  * library of Streamix.
  */
 
+#include <pthread.h>
 #include <stdarg.h>
 #include "smxconfig.h"
+#include "smxhmap.h"
 #include "smxutils.h"
 #include "smxlog.h"
 
@@ -1126,6 +1128,431 @@ bool smx_config_is_format_string(const char* s, bson_type_t type )
     return count == 1;
 }
 
+/*****************************************************************************/
+static void smx_config_net_props_key( char* key, size_t size,
+        const char* impl, const char* name, const char* id )
+{
+    // length prefixes keep the key unique even if a part contains a dot
+    if( name == NULL )
+        snprintf( key, size, "%zu:%s", strlen( impl ), impl );
+    else if( id == NULL )
+        snprintf( key, size, "%zu:%s%zu:%s", strlen( impl ), impl,
+                strlen( name ), name );
+    else
+        snprintf( key, size, "%zu:%s%zu:%s%zu:%s", strlen( impl ), impl,
+                strlen( name ), name, strlen( id ), id );
+}
+
+/*****************************************************************************/
+static smx_net_props_node_t* smx_config_net_props_add( smx_net_props_t* props,
+        const char* key, const char* path, smx_net_props_node_t* parent )
+{
+    smx_net_props_node_t* node = smx_hmap_get( props->nodes, key );
+    if( node != NULL )
+        return node;
+
+    node = smx_malloc( sizeof( struct smx_net_props_node_s ) );
+    if( node == NULL )
+        return NULL;
+
+    bson_init( &node->props );
+    node->has_props = false;
+    node->path = strdup( path );
+    node->parent = parent;
+    if( smx_hmap_put( props->nodes, key, node ) < 0 )
+    {
+        free( node->path );
+        free( node );
+        return NULL;
+    }
+    return node;
+}
+
+/*****************************************************************************/
+static int smx_config_net_props_set( smx_net_props_node_t* node,
+        bson_iter_t* iter )
+{
+    uint32_t len;
+    const uint8_t* data;
+
+    if( !BSON_ITER_HOLDS_DOCUMENT( iter ) )
+    {
+        SMX_LOG_MAIN( main, warn, "ignoring net properties '%s': not a"
+                " document", node->path );
+        return 0;
+    }
+
+    bson_iter_document( iter, &len, &data );
+    if( !bson_init_static( &node->props, data, len ) )
+        return -1;
+    node->has_props = true;
+    return 0;
+}
+
+/*****************************************************************************/
+static void smx_config_net_props_file_destroy( void* item )
+{
+    smx_config_file_t* file = item;
+    if( file->doc != NULL )
+        bson_destroy( file->doc );
+    free( file );
+}
+
+/*****************************************************************************/
+static void smx_config_net_props_file_collect( const char* key, void* val,
+        void* arg )
+{
+    bson_iter_t iter;
+    const char* path;
+    smx_config_file_t* file;
+    smx_net_props_node_t* node = val;
+    smx_net_props_t* props = arg;
+    ( void )key;
+
+    if( !node->has_props || !bson_iter_init_find( &iter, &node->props,
+                "config" ) || !BSON_ITER_HOLDS_UTF8( &iter ) )
+        return;
+
+    path = bson_iter_utf8( &iter, NULL );
+    if( smx_hmap_get( props->files, path ) != NULL )
+        return;
+
+    file = smx_malloc( sizeof( struct smx_config_file_s ) );
+    if( file == NULL )
+        return;
+
+    file->doc = NULL;
+    if( smx_hmap_put( props->files, path, file ) < 0 )
+        free( file );
+}
+
+/*****************************************************************************/
+static void smx_config_net_props_file_list( const char* key, void* val,
+        void* arg )
+{
+    smx_config_file_t*** list = arg;
+    smx_config_file_t* file = val;
+    file->path = key;
+    **list = file;
+    ( *list )++;
+}
+
+/*****************************************************************************/
+static void* smx_config_net_props_file_parse( void* arg )
+{
+    int rc;
+    unsigned int i;
+    bson_error_t error;
+    bson_json_reader_t* reader;
+    smx_config_file_t* file;
+    smx_config_file_job_t* job = arg;
+
+    while( ( i = __atomic_fetch_add( &job->next, 1, __ATOMIC_RELAXED ) )
+            < job->count )
+    {
+        file = job->files[i];
+        reader = bson_json_reader_new_from_file( file->path, &error );
+        if( reader == NULL )
+        {
+            SMX_LOG_MAIN( main, error, "failed to load net config file '%s':"
+                    " %s", file->path, error.message );
+            continue;
+        }
+        file->doc = bson_new();
+        rc = bson_json_reader_read( reader, file->doc, &error );
+        bson_json_reader_destroy( reader );
+        if( rc < 0 )
+        {
+            SMX_LOG_MAIN( main, error, "failed to parse net config file '%s':"
+                    " %s", file->path, error.message );
+            bson_destroy( file->doc );
+            file->doc = NULL;
+        }
+    }
+    return NULL;
+}
+
+/*****************************************************************************/
+static void smx_config_net_props_node_destroy( void* item )
+{
+    smx_net_props_node_t* node = item;
+    free( node->path );
+    free( node );
+}
+
+/*****************************************************************************/
+smx_net_props_t* smx_config_net_props_create( bson_t* conf )
+{
+    char key[1000];
+    char path[1000];
+    bson_iter_t i_nets, i_impl, i_name, i_id;
+    smx_net_props_node_t* n_impl;
+    smx_net_props_node_t* n_name;
+    smx_net_props_node_t* n_id;
+    uint64_t start = smx_time_get_ns();
+    smx_net_props_t* props = smx_malloc( sizeof( struct smx_net_props_s ) );
+    if( props == NULL )
+        return NULL;
+
+    props->lookup_cnt = 0;
+    props->resolve_time = 0;
+    props->load_time = 0;
+    props->files = NULL;
+    props->root = smx_malloc( sizeof( struct smx_net_props_node_s ) );
+    if( props->root != NULL )
+    {
+        // initialise the root before any error path destroys it
+        bson_init( &props->root->props );
+        props->root->has_props = false;
+        props->root->path = strdup( "_nets._default" );
+        props->root->parent = NULL;
+    }
+    props->nodes = smx_hmap_create( 64 );
+    if( props->root == NULL || props->nodes == NULL )
+        goto error;
+
+    if( !bson_iter_init_find( &i_nets, conf, "_nets" )
+            || !bson_iter_recurse( &i_nets, &i_impl ) )
+        goto error;
+
+    while( bson_iter_next( &i_impl ) )
+    {
+        if( strcmp( bson_iter_key( &i_impl ), "_default" ) == 0 )
+        {
+            if( smx_config_net_props_set( props->root, &i_impl ) < 0 )
+                goto error;
+            continue;
+        }
+        if( !bson_iter_recurse( &i_impl, &i_name ) )
+            continue;
+
+        smx_config_net_props_key( key, sizeof( key ),
+                bson_iter_key( &i_impl ), NULL, NULL );
+        snprintf( path, sizeof( path ), "_nets.%s._default",
+                bson_iter_key( &i_impl ) );
+        n_impl = smx_config_net_props_add( props, key, path, props->root );
+        if( n_impl == NULL )
+            goto error;
+
+        while( bson_iter_next( &i_name ) )
+        {
+            if( strcmp( bson_iter_key( &i_name ), "_default" ) == 0 )
+            {
+                if( smx_config_net_props_set( n_impl, &i_name ) < 0 )
+                    goto error;
+                continue;
+            }
+            if( !bson_iter_recurse( &i_name, &i_id ) )
+                continue;
+
+            smx_config_net_props_key( key, sizeof( key ),
+                    bson_iter_key( &i_impl ), bson_iter_key( &i_name ), NULL );
+            snprintf( path, sizeof( path ), "_nets.%s.%s._default",
+                    bson_iter_key( &i_impl ), bson_iter_key( &i_name ) );
+            n_name = smx_config_net_props_add( props, key, path, n_impl );
+            if( n_name == NULL )
+                goto error;
+
+            while( bson_iter_next( &i_id ) )
+            {
+                if( strcmp( bson_iter_key( &i_id ), "_default" ) == 0 )
+                {
+                    if( smx_config_net_props_set( n_name, &i_id ) < 0 )
+                        goto error;
+                    continue;
+                }
+                smx_config_net_props_key( key, sizeof( key ),
+                        bson_iter_key( &i_impl ), bson_iter_key( &i_name ),
+                        bson_iter_key( &i_id ) );
+                snprintf( path, sizeof( path ), "_nets.%s.%s.%s",
+                        bson_iter_key( &i_impl ), bson_iter_key( &i_name ),
+                        bson_iter_key( &i_id ) );
+                n_id = smx_config_net_props_add( props, key, path, n_name );
+                if( n_id == NULL
+                        || smx_config_net_props_set( n_id, &i_id ) < 0 )
+                    goto error;
+            }
+        }
+    }
+
+    props->index_time = smx_time_get_ns() - start;
+    SMX_LOG_MAIN( main, notice, "indexed %d net property levels in %.3f ms",
+            props->nodes->count + 1, props->index_time / 1000000.0 );
+    return props;
+
+error:
+    SMX_LOG_MAIN( main, error, "failed to build the net property index" );
+    smx_config_net_props_destroy( props );
+    return NULL;
+}
+
+/*****************************************************************************/
+void smx_config_net_props_destroy( smx_net_props_t* props )
+{
+    if( props == NULL )
+        return;
+
+    smx_hmap_destroy( props->files, smx_config_net_props_file_destroy );
+    smx_hmap_destroy( props->nodes, smx_config_net_props_node_destroy );
+    if( props->root != NULL )
+        smx_config_net_props_node_destroy( props->root );
+    free( props );
+}
+
+/*****************************************************************************/
+bool smx_config_net_props_find( smx_net_props_t* props,
+        smx_net_props_node_t* node, const char* prop, bson_type_t type,
+        bson_iter_t* iter )
+{
+    if( props != NULL )
+        props->lookup_cnt++;
+
+    while( node != NULL )
+    {
+        if( node->has_props && bson_iter_init_find( iter, &node->props, prop )
+                && bson_iter_type( iter ) == type )
+            return true;
+        node = node->parent;
+    }
+    return false;
+}
+
+/*****************************************************************************/
+bool smx_config_net_props_get_bool( smx_net_props_t* props,
+        smx_net_props_node_t* node, const char* prop )
+{
+    bson_iter_t iter;
+    if( smx_config_net_props_find( props, node, prop, BSON_TYPE_BOOL, &iter ) )
+        return bson_iter_bool( &iter );
+    return false;
+}
+
+/*****************************************************************************/
+int smx_config_net_props_get_int( smx_net_props_t* props,
+        smx_net_props_node_t* node, const char* prop )
+{
+    bson_iter_t iter;
+    if( smx_config_net_props_find( props, node, prop, BSON_TYPE_INT32, &iter ) )
+        return bson_iter_int32( &iter );
+    return 0;
+}
+
+/*****************************************************************************/
+const char* smx_config_net_props_get_string( smx_net_props_t* props,
+        smx_net_props_node_t* node, const char* prop )
+{
+    bson_iter_t iter;
+    if( smx_config_net_props_find( props, node, prop, BSON_TYPE_UTF8, &iter ) )
+        return bson_iter_utf8( &iter, NULL );
+    return NULL;
+}
+
+/*****************************************************************************/
+bool smx_config_net_props_get_file( smx_net_props_t* props, const char* path,
+        smx_config_file_t** file )
+{
+    if( props == NULL || props->files == NULL )
+        return false;
+
+    *file = smx_hmap_get( props->files, path );
+    return *file != NULL;
+}
+
+/*****************************************************************************/
+int smx_config_net_props_load_files( smx_net_props_t* props, int thread_cnt )
+{
+    int i;
+    pthread_t* ths;
+    smx_config_file_t** list;
+    smx_config_file_job_t job;
+    uint64_t start = smx_time_get_ns();
+
+    props->files = smx_hmap_create( 16 );
+    if( props->files == NULL )
+        return -1;
+
+    smx_config_net_props_file_collect( NULL, props->root, props );
+    smx_hmap_foreach( props->nodes, smx_config_net_props_file_collect, props );
+    if( props->files->count == 0 )
+        return 0;
+
+    job.count = props->files->count;
+    job.next = 0;
+    job.files = smx_malloc( sizeof( smx_config_file_t* ) * job.count );
+    if( job.files == NULL )
+        return -1;
+    list = job.files;
+    smx_hmap_foreach( props->files, smx_config_net_props_file_list, &list );
+
+    if( thread_cnt > ( int )job.count )
+        thread_cnt = job.count;
+    if( thread_cnt < 1 )
+        thread_cnt = 1;
+    ths = smx_malloc( sizeof( pthread_t ) * thread_cnt );
+    if( ths == NULL )
+    {
+        free( job.files );
+        return -1;
+    }
+
+    for( i = 0; i < thread_cnt; i++ )
+    {
+        if( pthread_create( &ths[i], NULL, smx_config_net_props_file_parse,
+                    &job ) != 0 )
+        {
+            SMX_LOG_MAIN( main, warn, "failed to create config loader"
+                    " thread %d", i );
+            break;
+        }
+    }
+    if( i == 0 )
+    {
+        /* no worker could be started, parse on the calling thread */
+        smx_config_net_props_file_parse( &job );
+    }
+    thread_cnt = i;
+    for( i = 0; i < thread_cnt; i++ )
+    {
+        pthread_join( ths[i], NULL );
+    }
+
+    props->load_time = smx_time_get_ns() - start;
+    SMX_LOG_MAIN( main, notice, "loaded %u net config files with %d threads"
+            " in %.3f ms", job.count, thread_cnt,
+            props->load_time / 1000000.0 );
+
+    free( ths );
+    free( job.files );
+    return 0;
+}
+
+/*****************************************************************************/
+smx_net_props_node_t* smx_config_net_props_lookup( smx_net_props_t* props,
+        const char* impl, const char* name, unsigned int id )
+{
+    char key[1000];
+    char id_str[16];
+    smx_net_props_node_t* node;
+
+    if( props == NULL )
+        return NULL;
+
+    snprintf( id_str, sizeof( id_str ), "%u", id );
+    smx_config_net_props_key( key, sizeof( key ), impl, name, id_str );
+    node = smx_hmap_get( props->nodes, key );
+    if( node != NULL )
+        return node;
+    smx_config_net_props_key( key, sizeof( key ), impl, name, NULL );
+    node = smx_hmap_get( props->nodes, key );
+    if( node != NULL )
+        return node;
+    smx_config_net_props_key( key, sizeof( key ), impl, NULL, NULL );
+    node = smx_hmap_get( props->nodes, key );
+    if( node != NULL )
+        return node;
+    return props->root;
+}
+
 /*****************************************************************************/
 bool smx_config_specifier_allowed_for_bson( char spec, bson_type_t type )
 {
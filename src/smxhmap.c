@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @author  Simon Maurer
+ *
+ * A string-keyed hash map for the runtime system library of Streamix
+ */
+
+#include <string.h>
+#include "smxhmap.h"
+#include "smxutils.h"
+
+/*****************************************************************************/
+static smx_hmap_item_t** smx_hmap_find( smx_hmap_t* map, const char* key,
+        uint64_t hash )
+{
+    smx_hmap_item_t** item = &map->buckets[hash & ( map->size - 1 )];
+    while( *item != NULL )
+    {
+        if( ( *item )->hash == hash && strcmp( ( *item )->key, key ) == 0 )
+            break;
+        item = &( *item )->next;
+    }
+    return item;
+}
+
+/*****************************************************************************/
+static int smx_hmap_grow( smx_hmap_t* map )
+{
+    unsigned int i;
+    unsigned int size = map->size * 2;
+    smx_hmap_item_t* item;
+    smx_hmap_item_t* next;
+    smx_hmap_item_t** buckets = calloc( size, sizeof( smx_hmap_item_t* ) );
+    if( buckets == NULL )
+        return -1;
+
+    for( i = 0; i < map->size; i++ )
+    {
+        item = map->buckets[i];
+        while( item != NULL )
+        {
+            next = item->next;
+            item->next = buckets[item->hash & ( size - 1 )];
+            buckets[item->hash & ( size - 1 )] = item;
+            item = next;
+        }
+    }
+    free( map->buckets );
+    map->buckets = buckets;
+    map->size = size;
+    return 0;
+}
+
+/*****************************************************************************/
+smx_hmap_t* smx_hmap_create( unsigned int size )
+{
+    unsigned int pow2 = 8;
+    smx_hmap_t* map = smx_malloc( sizeof( struct smx_hmap_s ) );
+    if( map == NULL )
+        return NULL;
+
+    while( pow2 < size )
+        pow2 *= 2;
+
+    map->buckets = calloc( pow2, sizeof( smx_hmap_item_t* ) );
+    if( map->buckets == NULL )
+    {
+        free( map );
+        return NULL;
+    }
+    map->size = pow2;
+    map->count = 0;
+    return map;
+}
+
+/*****************************************************************************/
+void smx_hmap_destroy( smx_hmap_t* map, void ( *cleanup )( void* ) )
+{
+    unsigned int i;
+    smx_hmap_item_t* item;
+    smx_hmap_item_t* next;
+
+    if( map == NULL )
+        return;
+
+    for( i = 0; i < map->size; i++ )
+    {
+        item = map->buckets[i];
+        while( item != NULL )
+        {
+            next = item->next;
+            if( cleanup != NULL )
+                cleanup( item->val );
+            free( item->key );
+            free( item );
+            item = next;
+        }
+    }
+    free( map->buckets );
+    free( map );
+}
+
+/*****************************************************************************/
+void smx_hmap_foreach( smx_hmap_t* map,
+        void ( *fn )( const char*, void*, void* ), void* arg )
+{
+    unsigned int i;
+    smx_hmap_item_t* item;
+
+    if( map == NULL )
+        return;
+
+    for( i = 0; i < map->size; i++ )
+        for( item = map->buckets[i]; item != NULL; item = item->next )
+            fn( item->key, item->val, arg );
+}
+
+/*****************************************************************************/
+void* smx_hmap_get( smx_hmap_t* map, const char* key )
+{
+    smx_hmap_item_t* item;
+
+    if( map == NULL || key == NULL )
+        return NULL;
+
+    item = *smx_hmap_find( map, key, smx_hmap_hash( key, strlen( key ) ) );
+    return ( item == NULL ) ? NULL : item->val;
+}
+
+/*****************************************************************************/
+uint64_t smx_hmap_hash( const void* data, size_t len )
+{
+    size_t i;
+    const unsigned char* bytes = data;
+    uint64_t hash = 14695981039346656037ULL;
+
+    for( i = 0; i < len; i++ )
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*****************************************************************************/
+int smx_hmap_put( smx_hmap_t* map, const char* key, void* val )
+{
+    uint64_t hash;
+    smx_hmap_item_t** slot;
+    smx_hmap_item_t* item;
+
+    if( map == NULL || key == NULL )
+        return -1;
+
+    hash = smx_hmap_hash( key, strlen( key ) );
+    slot = smx_hmap_find( map, key, hash );
+    if( *slot != NULL )
+        return -1;
+
+    item = smx_malloc( sizeof( struct smx_hmap_item_s ) );
+    if( item == NULL )
+        return -1;
+
+    item->key = strdup( key );
+    item->hash = hash;
+    item->val = val;
+    item->next = NULL;
+    *slot = item;
+    map->count++;
+
+    if( map->count > map->size - map->size / 4 )
+        smx_hmap_grow( map );
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @author  Simon Maurer
+ *
+ * The I/O service of the runtime system library of Streamix.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "smxch.h"
+#include "smxio.h"
+#include "smxlog.h"
+#include "smxnet.h"
+#include "smxutils.h"
+
+#define SMX_IO_MAX_EVENTS 64
+
+/*****************************************************************************/
+static void smx_io_dispatch( smx_io_t* io, smx_io_source_t* src,
+        uint32_t events )
+{
+    int rc;
+    smx_msg_t* msg = NULL;
+    struct epoll_event ev;
+
+    pthread_mutex_lock( &io->mutex );
+    if( !src->is_active )
+    {
+        pthread_mutex_unlock( &io->mutex );
+        return;
+    }
+
+    src->dispatches++;
+    rc = src->callback( src->net, src->fd, events, &msg );
+    if( msg != NULL )
+    {
+        smx_net_source_write( src->net, src->idx, msg );
+    }
+
+    if( rc < 0 )
+    {
+        // the source is exhausted, let the net drain its source channel
+        SMX_LOG_NET( src->net, notice, "fd source %d at index %d closed",
+                src->fd, src->idx );
+        epoll_ctl( io->epfd, EPOLL_CTL_DEL, src->fd, NULL );
+        src->is_active = false;
+        io->count--;
+        smx_channel_terminate_source(
+                src->net->sig->source.items[src->idx].port );
+    }
+    else
+    {
+        ev.events = src->events | EPOLLONESHOT;
+        ev.data.ptr = src;
+        if( epoll_ctl( io->epfd, EPOLL_CTL_MOD, src->fd, &ev ) < 0 )
+        {
+            SMX_LOG_NET( src->net, error, "failed to re-arm fd source %d: %s",
+                    src->fd, strerror( errno ) );
+        }
+    }
+    pthread_mutex_unlock( &io->mutex );
+}
+
+/*****************************************************************************/
+static void* smx_io_run( void* arg )
+{
+    int i;
+    int n;
+    smx_io_t* io = arg;
+    struct epoll_event events[SMX_IO_MAX_EVENTS];
+
+    SMX_LOG_MAIN( main, notice, "start I/O thread" );
+    while( true )
+    {
+        n = epoll_wait( io->epfd, events, SMX_IO_MAX_EVENTS, -1 );
+        if( n < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            SMX_LOG_MAIN( main, error, "epoll_wait failed: %s",
+                    strerror( errno ) );
+            break;
+        }
+        for( i = 0; i < n; i++ )
+        {
+            if( events[i].data.ptr == NULL )
+                goto end;
+            smx_io_dispatch( io, events[i].data.ptr, events[i].events );
+        }
+    }
+
+end:
+    SMX_LOG_MAIN( main, notice, "terminate I/O thread" );
+    return NULL;
+}
+
+/*****************************************************************************/
+int smx_io_add( smx_io_t* io, smx_net_t* net, int idx, int fd,
+        uint32_t events, smx_source_fd_callback_t callback )
+{
+    struct epoll_event ev;
+    smx_io_source_t* src;
+
+    if( io == NULL || net == NULL || callback == NULL )
+        return -1;
+
+    src = smx_malloc( sizeof( struct smx_io_source_s ) );
+    if( src == NULL )
+        return -1;
+
+    src->fd = fd;
+    src->events = events;
+    src->idx = idx;
+    src->is_active = true;
+    src->net = net;
+    src->callback = callback;
+    src->dispatches = 0;
+
+    ev.events = events | EPOLLONESHOT;
+    ev.data.ptr = src;
+    pthread_mutex_lock( &io->mutex );
+    if( epoll_ctl( io->epfd, EPOLL_CTL_ADD, fd, &ev ) < 0 )
+    {
+        pthread_mutex_unlock( &io->mutex );
+        SMX_LOG_NET( net, error, "failed to add fd source %d: %s", fd,
+                strerror( errno ) );
+        free( src );
+        return -1;
+    }
+    src->next = io->sources;
+    io->sources = src;
+    io->count++;
+    pthread_mutex_unlock( &io->mutex );
+
+    return 0;
+}
+
+/*****************************************************************************/
+smx_io_t* smx_io_create()
+{
+    struct epoll_event ev;
+    smx_io_t* io = smx_malloc( sizeof( struct smx_io_s ) );
+    if( io == NULL )
+        return NULL;
+
+    io->count = 0;
+    io->sources = NULL;
+    io->epfd = epoll_create1( EPOLL_CLOEXEC );
+    io->evfd = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+    if( io->epfd < 0 || io->evfd < 0 )
+    {
+        SMX_LOG_MAIN( main, error, "failed to create I/O service: %s",
+                strerror( errno ) );
+        goto error;
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if( epoll_ctl( io->epfd, EPOLL_CTL_ADD, io->evfd, &ev ) < 0 )
+    {
+        SMX_LOG_MAIN( main, error, "failed to register I/O stop event: %s",
+                strerror( errno ) );
+        goto error;
+    }
+
+    pthread_mutex_init( &io->mutex, NULL );
+    if( pthread_create( &io->thread, NULL, smx_io_run, io ) != 0 )
+    {
+        SMX_LOG_MAIN( main, error, "failed to start I/O thread" );
+        pthread_mutex_destroy( &io->mutex );
+        goto error;
+    }
+
+    return io;
+
+error:
+    if( io->epfd >= 0 )
+        close( io->epfd );
+    if( io->evfd >= 0 )
+        close( io->evfd );
+    free( io );
+    return NULL;
+}
+
+/*****************************************************************************/
+void smx_io_destroy( smx_io_t* io )
+{
+    uint64_t val = 1;
+    smx_io_source_t* src;
+
+    if( io == NULL )
+        return;
+
+    if( write( io->evfd, &val, sizeof( val ) ) != sizeof( val ) )
+    {
+        SMX_LOG_MAIN( main, error, "failed to stop I/O thread: %s",
+                strerror( errno ) );
+    }
+    pthread_join( io->thread, NULL );
+
+    while( io->sources != NULL )
+    {
+        src = io->sources;
+        io->sources = src->next;
+        SMX_LOG_MAIN( main, info, "fd source %d handled %lu events", src->fd,
+                src->dispatches );
+        free( src );
+    }
+    pthread_mutex_destroy( &io->mutex );
+    close( io->evfd );
+    close( io->epfd );
+    free( io );
+}
+
+/*****************************************************************************/
+void smx_io_remove_net( smx_io_t* io, smx_net_t* net )
+{
+    smx_io_source_t* src;
+
+    if( io == NULL )
+        return;
+
+    pthread_mutex_lock( &io->mutex );
+    for( src = io->sources; src != NULL; src = src->next )
+    {
+        if( src->net == net && src->is_active )
+        {
+            epoll_ctl( io->epfd, EPOLL_CTL_DEL, src->fd, NULL );
+            src->is_active = false;
+            io->count--;
+        }
+    }
+    pthread_mutex_unlock( &io->mutex );
+}
@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @author  Simon Maurer
+ *
+ * The real-time memory mode of the runtime system library of Streamix.
+ */
+
+#define _GNU_SOURCE
+#include <alloca.h>
+#include <errno.h>
+#include <malloc.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "smxconfig.h"
+#include "smxlog.h"
+#include "smxmem.h"
+#include "smxutils.h"
+
+/**
+ * The part of the stack which is not prefaulted. It covers the frames of the
+ * net start routine and the thread setup of libc.
+ */
+#define SMX_MEM_STACK_MARGIN ( 16 * 1024 )
+
+/*****************************************************************************/
+static void smx_mem_touch( volatile char* mem, size_t size )
+{
+    size_t i;
+    long page_size = sysconf( _SC_PAGESIZE );
+
+    for( i = 0; i < size; i += page_size )
+        mem[i] = 0;
+}
+
+/*****************************************************************************/
+int smx_mem_init( smx_rts_t* rts )
+{
+    int stack_size = 0;
+    int msg_reserve = 0;
+    char* reserve;
+    long minflt, majflt;
+
+    rts->mem.is_locked = smx_config_get_bool( rts->conf, "_rt_memory.lock" );
+    smx_config_init_int( rts->conf, "_rt_memory.stack_size", &stack_size );
+    smx_config_init_int( rts->conf, "_rt_memory.msg_reserve", &msg_reserve );
+    rts->mem.stack_size = ( stack_size > 0 ) ? ( size_t )stack_size * 1024 : 0;
+    rts->mem.msg_reserve = ( msg_reserve > 0 ) ? ( size_t )msg_reserve * 1024
+        : 0;
+    if( !rts->mem.is_locked )
+    {
+        if( rts->mem.msg_reserve > 0 )
+        {
+            SMX_LOG_MAIN( main, warn, "a message reserve requires locked"
+                    " memory, ignoring" );
+            rts->mem.msg_reserve = 0;
+        }
+        return 0;
+    }
+
+    if( mlockall( MCL_CURRENT | MCL_FUTURE ) < 0 )
+    {
+        SMX_LOG_MAIN( main, error, "failed to lock memory: %s",
+                strerror( errno ) );
+        rts->mem.is_locked = false;
+        rts->mem.msg_reserve = 0;
+        return -1;
+    }
+
+    // never return freed memory to the kernel and serve all threads from the
+    // main arena such that the touched reserve is reused by every net
+    mallopt( M_TRIM_THRESHOLD, -1 );
+    mallopt( M_MMAP_MAX, 0 );
+    mallopt( M_ARENA_MAX, 1 );
+
+    if( rts->mem.msg_reserve > 0 )
+    {
+        reserve = smx_malloc( rts->mem.msg_reserve );
+        if( reserve == NULL )
+            return -1;
+        smx_mem_touch( reserve, rts->mem.msg_reserve );
+        free( reserve );
+    }
+
+    smx_mem_get_faults( &minflt, &majflt );
+    SMX_LOG_MAIN( main, notice, "real-time memory mode enabled (stack size:"
+            " %zu bytes, message reserve: %zu bytes, page faults: %ld minor,"
+            " %ld major)", rts->mem.stack_size, rts->mem.msg_reserve, minflt,
+            majflt );
+    return 0;
+}
+
+/*****************************************************************************/
+int smx_mem_get_faults( long* minflt, long* majflt )
+{
+    struct rusage usage;
+
+    if( getrusage( RUSAGE_THREAD, &usage ) < 0 )
+    {
+        *minflt = 0;
+        *majflt = 0;
+        return -1;
+    }
+    *minflt = usage.ru_minflt;
+    *majflt = usage.ru_majflt;
+    return 0;
+}
+
+/*****************************************************************************/
+void smx_mem_prefault_stack( size_t size )
+{
+    volatile char* stack;
+
+    if( size <= SMX_MEM_STACK_MARGIN )
+        return;
+
+    stack = alloca( size - SMX_MEM_STACK_MARGIN );
+    smx_mem_touch( stack, size - SMX_MEM_STACK_MARGIN );
+}
@@ -13,13 +13,234 @@
 #include <stdbool.h>
 #include <string.h>
 #include <pthread.h>
+#include <urcu.h>
+#include "smxce.h"
 #include "smxch.h"
 #include "smxconfig.h"
+#include "smxio.h"
+#include "smxmem.h"
 #include "smxnet.h"
 #include "smxmsg.h"
 #include "smxprofiler.h"
+#include "smxrts.h"
+#include "smxstats.h"
 #include "smxutils.h"
 
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+#ifndef SCHED_FLAG_RESET_ON_FORK
+#define SCHED_FLAG_RESET_ON_FORK 0x01
+#endif
+
+/**
+ * The argument of the sched_setattr system call which has no glibc wrapper.
+ */
+struct smx_sched_attr_s
+{
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+/*****************************************************************************/
+static void smx_net_port_add( int* count, int* len, smx_channel_t*** ports,
+        smx_channel_t* ch )
+{
+    int i;
+    smx_channel_t** new_ports;
+
+    for( i = 0; i < *len; i++ )
+    {
+        if( ( *ports )[i] == NULL )
+            break;
+    }
+    if( i == *len )
+    {
+        new_ports = realloc( *ports, sizeof( smx_channel_t* ) * ( *len + 1 ) );
+        if( new_ports == NULL )
+        {
+            SMX_LOG_MAIN( main, error, "failed to grow port array" );
+            return;
+        }
+        *ports = new_ports;
+        ( *len )++;
+    }
+    ( *ports )[i] = ch;
+    if( i >= *count )
+        *count = i + 1;
+}
+
+/*****************************************************************************/
+static void smx_net_port_remove( int count, smx_channel_t** ports,
+        smx_channel_t* ch )
+{
+    int i;
+
+    for( i = 0; i < count; i++ )
+    {
+        if( ports[i] == ch )
+            ports[i] = NULL;
+    }
+}
+
+/*****************************************************************************/
+static int smx_net_apply_update( smx_net_t* h, smx_net_update_t* update )
+{
+    smx_channel_t* ch = update->ch;
+    smx_collector_t* collector;
+
+    switch( update->action )
+    {
+        case SMX_NET_UPDATE_ADD_IN:
+            smx_net_port_add( &h->sig->in.count, &h->sig->in.len,
+                    &h->sig->in.ports, ch );
+            if( h->impl != NULL && strcmp( h->impl, "smx_rn" ) == 0 )
+            {
+                // only attach once the channel is in the port array such that
+                // a write never wakes the node on an unknown channel
+                collector = h->attr;
+                pthread_mutex_lock( &ch->ch_mutex );
+                pthread_mutex_lock( &collector->col_mutex );
+                ch->collector = collector;
+                collector->ch_count++;
+                collector->count += ch->fifo->count;
+                if( collector->count > 0 )
+                {
+                    smx_channel_change_collector_state( ch,
+                            SMX_CHANNEL_READY );
+                }
+                pthread_mutex_unlock( &collector->col_mutex );
+                pthread_mutex_unlock( &ch->ch_mutex );
+            }
+            SMX_LOG_NET( h, notice, "connected input channel '%s'",
+                    ch->name );
+            break;
+        case SMX_NET_UPDATE_ADD_OUT:
+            smx_net_port_add( &h->sig->out.count, &h->sig->out.len,
+                    &h->sig->out.ports, ch );
+            SMX_LOG_NET( h, notice, "connected output channel '%s'",
+                    ch->name );
+            break;
+        case SMX_NET_UPDATE_REMOVE_IN:
+            smx_net_port_remove( h->sig->in.count, h->sig->in.ports, ch );
+            if( ch->collector != NULL )
+            {
+                pthread_mutex_lock( &ch->ch_mutex );
+                pthread_mutex_lock( &ch->collector->col_mutex );
+                if( ch->source->state != SMX_CHANNEL_END )
+                {
+                    // a terminated producer already left the collector
+                    ch->collector->ch_count--;
+                }
+                ch->collector->count -= ch->fifo->count;
+                pthread_mutex_unlock( &ch->collector->col_mutex );
+                pthread_mutex_unlock( &ch->ch_mutex );
+                ch->collector = NULL;
+            }
+            __atomic_store_n( &ch->source->net, NULL, __ATOMIC_RELEASE );
+            SMX_LOG_NET( h, notice, "disconnected input channel '%s'",
+                    ch->name );
+            break;
+        case SMX_NET_UPDATE_REMOVE_OUT:
+            smx_net_port_remove( h->sig->out.count, h->sig->out.ports, ch );
+            if( update->terminate )
+            {
+                smx_channel_terminate_source( ch );
+                smx_collector_terminate( ch );
+            }
+            __atomic_store_n( &ch->sink->net, NULL, __ATOMIC_RELEASE );
+            SMX_LOG_NET( h, notice, "disconnected output channel '%s'",
+                    ch->name );
+            break;
+        case SMX_NET_UPDATE_STOP:
+            SMX_LOG_NET( h, notice, "stop requested" );
+            return SMX_NET_END;
+    }
+    return SMX_NET_CONTINUE;
+}
+
+/*****************************************************************************/
+static void smx_net_wake( smx_net_t* h )
+{
+    int i;
+    smx_channel_t* ch;
+    smx_collector_t* collector;
+
+    // a net blocked on its inputs applies its updates once woken up
+    for( i = 0; i < h->sig->in.count; i++ )
+    {
+        ch = h->sig->in.ports[i];
+        if( ch == NULL )
+            continue;
+        pthread_mutex_lock( &ch->ch_mutex );
+        pthread_cond_broadcast( &ch->source->ch_cv );
+        pthread_mutex_unlock( &ch->ch_mutex );
+    }
+    for( i = 0; i < h->sig->source.count; i++ )
+    {
+        ch = h->sig->source.items[i].port;
+        if( ch == NULL )
+            continue;
+        pthread_mutex_lock( &ch->ch_mutex );
+        pthread_cond_broadcast( &ch->source->ch_cv );
+        pthread_mutex_unlock( &ch->ch_mutex );
+    }
+    if( h->impl != NULL && strcmp( h->impl, "smx_rn" ) == 0
+            && h->attr != NULL )
+    {
+        collector = h->attr;
+        pthread_mutex_lock( &collector->col_mutex );
+        pthread_cond_broadcast( &collector->col_cv );
+        pthread_mutex_unlock( &collector->col_mutex );
+    }
+}
+
+/*****************************************************************************/
+bool smx_net_has_updates( smx_net_t* h )
+{
+    return __atomic_load_n( &h->updates, __ATOMIC_ACQUIRE ) != NULL
+        || __atomic_load_n( &h->conf_pending, __ATOMIC_ACQUIRE ) != NULL;
+}
+
+/*****************************************************************************/
+int smx_net_apply_updates( smx_net_t* h )
+{
+    int state = SMX_NET_CONTINUE;
+    smx_net_update_t* updates;
+    smx_net_update_t* update;
+    smx_net_update_t* prev = NULL;
+
+    // the ports are read by other threads holding the net mutex
+    pthread_mutex_lock( &h->rts->net_mutex );
+    updates = h->updates;
+    h->updates = NULL;
+
+    // updates are queued in reverse order
+    while( updates != NULL )
+    {
+        update = updates;
+        updates = update->next;
+        update->next = prev;
+        prev = update;
+    }
+    while( prev != NULL )
+    {
+        update = prev;
+        prev = update->next;
+        if( smx_net_apply_update( h, update ) == SMX_NET_END )
+            state = SMX_NET_END;
+        free( update );
+    }
+    pthread_mutex_unlock( &h->rts->net_mutex );
+    return state;
+}
+
 /*****************************************************************************/
 smx_msg_t* smx_net_collector_read( void* h, smx_collector_t* collector,
         smx_channel_t** in, int count_in, int* last_idx )
@@ -27,11 +248,24 @@ smx_msg_t* smx_net_collector_read( void* h, smx_collector_t* collector,
     int i, ch_count, ready_cnt;
     smx_msg_t* msg = NULL;
     smx_channel_t* ch = NULL;
+    smx_net_t* net = h;
     int rc = 0;
 
     pthread_mutex_lock( &collector->col_mutex );
     while( collector->state == SMX_CHANNEL_PENDING && rc == 0 )
     {
+        if( __atomic_load_n( &net->updates, __ATOMIC_ACQUIRE ) != NULL )
+        {
+            // apply topology updates while waiting, e.g. to stop writing to a
+            // net which is drained
+            pthread_mutex_unlock( &collector->col_mutex );
+            if( smx_net_apply_updates( net ) == SMX_NET_END )
+                return NULL;
+            in = net->sig->in.ports;
+            count_in = net->sig->in.len;
+            pthread_mutex_lock( &collector->col_mutex );
+            continue;
+        }
         smx_profiler_log_ch( h, in[0], NULL,
                 SMX_PROFILER_ACTION_CH_READ_COLLECTOR_BLOCK,
                 collector->count );
@@ -40,6 +274,15 @@ smx_msg_t* smx_net_collector_read( void* h, smx_collector_t* collector,
     }
     pthread_mutex_unlock( &collector->col_mutex );
 
+    if( __atomic_load_n( &net->updates, __ATOMIC_ACQUIRE ) != NULL )
+    {
+        // input channels may have been connected while waiting
+        if( smx_net_apply_updates( net ) == SMX_NET_END )
+            return NULL;
+        in = net->sig->in.ports;
+        count_in = net->sig->in.len;
+    }
+
     if( collector->count > 0 )
     {
         ch_count = count_in;
@@ -76,16 +319,88 @@ smx_msg_t* smx_net_collector_read( void* h, smx_collector_t* collector,
 }
 
 /*****************************************************************************/
-smx_net_t* smx_net_create( unsigned int id, const char* name,
-        const char* impl, const char* cat_name, smx_rts_t* rts, int prio )
+void* smx_net_conf_listen( void* arg )
 {
-    int niceness = 0;
-    if( id >= SMX_MAX_NETS )
+    smx_net_t* h = arg;
+    smx_channel_t* conf_port;
+    smx_msg_t* msg;
+    bson_t* conf;
+    bson_t* old;
+    bson_error_t b_err;
+
+    conf_port = smx_get_channel_by_name( h->sig->in.ports, h->sig->in.count,
+            h->conf_port_name );
+    smx_set_read_timeout( conf_port, 0, 0 );
+    SMX_LOG_NET( h, notice, "listening for dynamic configuration updates" );
+
+    while( true )
     {
-        SMX_LOG_MAIN( main, fatal, "net count exeeds maximum %d", id );
-        return NULL;
+        msg = smx_channel_await_and_read( h, conf_port );
+        if( msg == NULL )
+        {
+            if( smx_get_read_error( conf_port ) == SMX_CHANNEL_ERR_TIMEOUT )
+                continue;
+            break;
+        }
+
+        conf = bson_new_from_json( msg->data, msg->size, &b_err );
+        if( conf == NULL )
+        {
+            SMX_LOG_NET( h, error, "unable to parse dynamic configuration"
+                    " update: %s", b_err.message );
+        }
+        else
+        {
+            // an update which was not yet applied is superseded
+            old = __atomic_exchange_n( &h->conf_pending, conf,
+                    __ATOMIC_ACQ_REL );
+            if( old != NULL )
+            {
+                bson_destroy( old );
+            }
+            SMX_LOG_NET( h, debug, "dynamic configuration update received" );
+            pthread_mutex_lock( &h->rts->net_mutex );
+            smx_net_wake( h );
+            pthread_mutex_unlock( &h->rts->net_mutex );
+        }
+        SMX_MSG_DESTROY( h, msg );
     }
 
+    SMX_LOG_NET( h, notice, "stop listening for dynamic configuration"
+            " updates" );
+    return NULL;
+}
+
+/*****************************************************************************/
+void smx_net_apply_conf( smx_net_t* h )
+{
+    bson_t* conf;
+    unsigned long version;
+
+    conf = __atomic_exchange_n( &h->conf_pending, NULL, __ATOMIC_ACQ_REL );
+    if( conf == NULL )
+        return;
+
+    if( h->conf != h->static_conf )
+    {
+        bson_destroy( h->conf );
+    }
+    h->conf = conf;
+    h->dyn_conf = conf;
+    version = __atomic_add_fetch( &h->conf_version, 1, __ATOMIC_RELEASE );
+    SMX_LOG_NET( h, notice, "dynamic configuration updated (version %lu)",
+            version );
+}
+
+/*****************************************************************************/
+smx_net_t* smx_net_create( unsigned int id, const char* name,
+        const char* impl, const char* cat_name, smx_rts_t* rts, int prio )
+{
+    int niceness = 0;
+    int dump_period;
+    uint64_t start;
+    smx_net_props_t* props;
+    smx_net_props_node_t* node;
     smx_net_t* net = smx_malloc( sizeof( struct smx_net_s ) );
     if( net == NULL )
         return NULL;
@@ -96,6 +411,17 @@ smx_net_t* smx_net_create( unsigned int id, const char* name,
         free( net );
         return NULL;
     }
+    net->stats = smx_malloc( sizeof( struct smx_net_stats_s ) );
+    if( net->stats == NULL )
+    {
+        free( net->sig );
+        free( net );
+        return NULL;
+    }
+    smx_hist_init( &net->stats->await );
+    smx_hist_init( &net->stats->impl );
+    smx_hist_init( &net->stats->loop );
+    net->stats->last_dump = 0;
     net->last_count_wall.tv_sec = 0;
     net->last_count_wall.tv_nsec = 0;
     net->start_wall.tv_sec = 0;
@@ -122,24 +448,49 @@ smx_net_t* smx_net_create( unsigned int id, const char* name,
     net->attr = NULL;
     net->conf = NULL;
     net->static_conf = NULL;
+    net->has_shared_conf = false;
     net->dyn_conf = NULL;
-    smx_net_get_json_doc( net, rts->conf, name, impl, id );
-    net->has_profiler = smx_net_get_boolean_prop( rts->conf, name, impl, id,
+    net->conf_pending = NULL;
+    start = smx_time_get_ns();
+    props = rts->net_props;
+    node = smx_config_net_props_lookup( props, impl, name, id );
+    smx_net_get_json_doc_props( net, props, node );
+    net->has_profiler = smx_config_net_props_get_bool( props, node,
             "profiler" );
-    net->has_type_filter = smx_net_get_boolean_prop( rts->conf, name, impl, id,
+    net->has_type_filter = smx_config_net_props_get_bool( props, node,
             "type_filter" );
-    net->is_disabled = smx_net_get_boolean_prop( rts->conf, name, impl, id,
+    net->is_disabled = smx_config_net_props_get_bool( props, node,
             "is_disabled" );
-    net->conf_port_name = smx_net_get_string_prop( rts->conf, name, impl, id,
+    net->conf_port_name = smx_config_net_props_get_string( props, node,
             "dyn_conf_port" );
-    net->conf_port_timeout = smx_net_get_int_prop( rts->conf, name, impl, id,
+    net->conf_port_timeout = smx_config_net_props_get_int( props, node,
             "dyn_conf_timeout" );
-    net->expected_rate = smx_net_get_int_prop( rts->conf, name, impl, id,
+    net->has_live_conf = smx_config_net_props_get_bool( props, node,
+            "dyn_conf_live" );
+    net->conf_version = 0;
+    net->is_ready = false;
+    net->is_running = false;
+    net->has_thread = false;
+    net->updates = NULL;
+    net->next = NULL;
+    net->expected_rate = smx_config_net_props_get_int( props, node,
             "expected_rate" );
-    net->shared_state_key = smx_net_get_string_prop( rts->conf, name, impl, id,
+    net->shared_state_key = smx_config_net_props_get_string( props, node,
             "shared_state_key" );
-    niceness = smx_net_get_int_prop( rts->conf, name, impl, id,
-            "niceness" );
+    niceness = smx_config_net_props_get_int( props, node, "niceness" );
+    dump_period = smx_config_net_props_get_int( props, node,
+            "stats_dump_period" );
+    if( dump_period < 0 )
+    {
+        SMX_LOG_NET( net, warn, "negative stats_dump_period %d, periodic"
+                " statistics dumps are disabled", dump_period );
+        dump_period = 0;
+    }
+    net->stats->dump_period = ( uint64_t )dump_period * SMX_NSEC_PER_SEC;
+    net->pacer = smx_net_create_pacer( net,
+            smx_config_net_props_get_string( props, node, "rate_pacing" ) );
+    if( props != NULL )
+        props->resolve_time += smx_time_get_ns() - start;
     if( niceness > 0 )
     {
         SMX_LOG_NET( net, warn, "cannot set a niceness level of %d: must"
@@ -151,23 +502,148 @@ smx_net_t* smx_net_create( unsigned int id, const char* name,
                 " already has a real-time priority of %d assigned",
                 niceness, net->priority );
     }
-    else
+    else if( niceness < 0 )
     {
         net->priority = niceness;
     }
+    net->sched_dl = smx_net_create_sched_dl( net,
+            smx_config_net_props_get_int( props, node, "dl_runtime" ),
+            smx_config_net_props_get_int( props, node, "dl_deadline" ),
+            smx_config_net_props_get_int( props, node, "dl_period" ) );
+    net->wcet = ( uint64_t )smx_config_net_props_get_int( props, node,
+            "wcet" ) * 1000;
+    net->ce = NULL;
+    if( smx_config_net_props_get_bool( props, node, "cyclic_executive" ) )
+    {
+        if( net->expected_rate <= 0 )
+        {
+            SMX_LOG_NET( net, warn, "a cyclic executive requires a positive"
+                    " expected_rate, ignoring" );
+        }
+        else
+        {
+            net->ce = smx_ce_assign( rts, smx_config_net_props_get_int( props,
+                        node, "ce_core" ) );
+        }
+    }
 
     rts->net_cnt++;
     SMX_LOG_MAIN( net, info, "create net instance %s(%d)", name, id );
     return net;
 }
 
+/*****************************************************************************/
+static smx_net_pacer_t* smx_net_alloc_pacer( smx_net_pacing_t policy,
+        uint64_t period )
+{
+    smx_net_pacer_t* pacer = smx_malloc( sizeof( struct smx_net_pacer_s ) );
+    if( pacer == NULL )
+        return NULL;
+
+    pacer->policy = policy;
+    pacer->period = period;
+    pacer->next = 0;
+    pacer->overruns = 0;
+    pacer->skipped = 0;
+    smx_hist_init( &pacer->jitter );
+
+    return pacer;
+}
+
+/*****************************************************************************/
+smx_net_pacer_t* smx_net_create_pacer( smx_net_t* h, const char* policy )
+{
+    smx_net_pacer_t* pacer;
+    smx_net_pacing_t pacing;
+
+    if( policy == NULL || strcmp( policy, "none" ) == 0 )
+    {
+        return NULL;
+    }
+    else if( strcmp( policy, "catch_up" ) == 0 )
+    {
+        pacing = SMX_NET_PACING_CATCH_UP;
+    }
+    else if( strcmp( policy, "skip" ) == 0 )
+    {
+        pacing = SMX_NET_PACING_SKIP;
+    }
+    else
+    {
+        SMX_LOG_NET( h, warn, "unknown rate pacing policy '%s', ignoring",
+                policy );
+        return NULL;
+    }
+
+    if( h->expected_rate <= 0 )
+    {
+        SMX_LOG_NET( h, warn, "rate pacing requires a positive expected_rate,"
+                " ignoring" );
+        return NULL;
+    }
+
+    pacer = smx_net_alloc_pacer( pacing, SMX_NSEC_PER_SEC / h->expected_rate );
+    if( pacer == NULL )
+        return NULL;
+
+    SMX_LOG_NET( h, notice, "pace net loop at %d Hz with policy '%s'",
+            h->expected_rate, policy );
+
+    return pacer;
+}
+
+/*****************************************************************************/
+smx_net_sched_dl_t* smx_net_create_sched_dl( smx_net_t* h, int runtime,
+        int deadline, int period )
+{
+    smx_net_sched_dl_t* dl;
+
+    if( runtime <= 0 )
+        return NULL;
+
+    if( h->priority <= 0 )
+    {
+        SMX_LOG_NET( h, warn, "SCHED_DEADLINE requires a time-triggered net"
+                " with a real-time priority, ignoring" );
+        return NULL;
+    }
+
+    if( deadline <= 0 )
+        deadline = period;
+    if( period <= 0 || runtime > deadline || deadline > period )
+    {
+        SMX_LOG_NET( h, warn, "invalid SCHED_DEADLINE parameters (runtime: %d"
+                " us, deadline: %d us, period: %d us): runtime <= deadline <="
+                " period must hold, ignoring", runtime, deadline, period );
+        return NULL;
+    }
+
+    dl = smx_malloc( sizeof( struct smx_net_sched_dl_s ) );
+    if( dl == NULL )
+        return NULL;
+
+    dl->runtime = ( uint64_t )runtime * 1000;
+    dl->deadline = ( uint64_t )deadline * 1000;
+    dl->period = ( uint64_t )period * 1000;
+    dl->is_active = false;
+
+    return dl;
+}
+
 /*****************************************************************************/
 void smx_net_destroy( smx_net_t* h )
 {
     int i;
+    smx_net_update_t* update;
 
     if( h != NULL )
     {
+        while( h->updates != NULL )
+        {
+            update = h->updates;
+            h->updates = update->next;
+            free( update );
+        }
         if( h->name != NULL )
         {
             free( h->name );
@@ -176,7 +652,7 @@ void smx_net_destroy( smx_net_t* h )
         {
             free( h->impl );
         }
-        if( h->static_conf != NULL )
+        if( h->static_conf != NULL && !h->has_shared_conf )
         {
             bson_destroy( h->static_conf );
         }
@@ -184,8 +660,13 @@ void smx_net_destroy( smx_net_t* h )
         {
             bson_destroy( h->dyn_conf );
         }
+        if( h->conf_pending != NULL )
+        {
+            bson_destroy( h->conf_pending );
+        }
         if( h->sig != NULL )
         {
+            smx_io_remove_net( h->rts->io, h );
             for( i = 0; i < h->sig->source.count; i++ )
             {
                 smx_channel_destroy( h->sig->source.items[i].port );
@@ -200,6 +681,18 @@ void smx_net_destroy( smx_net_t* h )
             }
             free( h->sig );
         }
+        if( h->stats != NULL )
+        {
+            free( h->stats );
+        }
+        if( h->pacer != NULL )
+        {
+            free( h->pacer );
+        }
+        if( h->sched_dl != NULL )
+        {
+            free( h->sched_dl );
+        }
         free( h );
     }
 }
@@ -284,6 +777,15 @@ int smx_net_get_int_prop( bson_t* conf, const char* name, const char* impl,
     return false;
 }
 
+/*****************************************************************************/
+smx_net_stats_t* smx_net_get_stats( smx_net_t* h )
+{
+    if( h == NULL )
+        return NULL;
+
+    return h->stats;
+}
+
 /*****************************************************************************/
 int smx_net_get_json_doc( smx_net_t* h, bson_t* conf, const char* name,
         const char* impl, unsigned int id )
@@ -317,53 +819,39 @@ int smx_net_get_json_doc( smx_net_t* h, bson_t* conf, const char* name,
 int smx_net_get_json_doc_item( smx_net_t* h, bson_t* conf,
         const char* search_str )
 {
-    int rc;
-    uint32_t len;
-    const uint8_t* nets;
-    const char* config;
     bson_iter_t iter;
     bson_iter_t child;
-    bson_json_reader_t *reader;
-    bson_error_t error;
     if( bson_iter_init( &iter, conf ) && bson_iter_find_descendant( &iter,
-                search_str, &child ) && BSON_ITER_HOLDS_DOCUMENT( &child ) )
+                search_str, &child ) )
     {
-        bson_iter_document( &child, &len, &nets );
-        h->static_conf = bson_new_from_data( nets, len );
-        h->conf = h->static_conf;
-        SMX_LOG_NET( h, notice, "load configuration '%s'", search_str );
-        return 0;
+        return smx_net_load_conf( h, &child, search_str );
     }
-    else if( bson_iter_init( &iter, conf ) && bson_iter_find_descendant( &iter,
-                search_str, &child ) && BSON_ITER_HOLDS_UTF8( &child ) )
-    {
-        config = bson_iter_utf8( &child, NULL );
-        reader = bson_json_reader_new_from_file( config, &error );
-        if( reader == NULL )
-        {
-            SMX_LOG_NET( h, error, "failed to load net config file '%s': %s",
-                    config, error.message );
-            return -1;
-        }
+    SMX_LOG_NET( h, debug, "no configuration loaded from '%s'", search_str );
+    return -1;
+}
 
-        h->static_conf = bson_new();
-        rc = bson_json_reader_read( reader, h->static_conf, &error );
-        h->conf = h->static_conf;
-        if( rc < 0 )
+/*****************************************************************************/
+int smx_net_get_json_doc_props( smx_net_t* h, smx_net_props_t* props,
+        smx_net_props_node_t* node )
+{
+    bson_iter_t iter;
+    char search_str[1000];
+
+    if( props != NULL )
+        props->lookup_cnt++;
+
+    while( node != NULL )
+    {
+        if( node->has_props && bson_iter_init_find( &iter, &node->props,
+                    "config" ) )
         {
-            SMX_LOG_NET( h, error,
-                    "failed to parse net config file '%s': %s",
-                    config, error.message );
-            return -1;
+            snprintf( search_str, sizeof( search_str ), "%s.config",
+                    node->path );
+            if( smx_net_load_conf( h, &iter, search_str ) == 0 )
+                return 0;
         }
-
-        bson_json_reader_destroy( reader );
-        SMX_LOG_NET( h, notice,
-                "load config file '%s' of configuration item '%s'",
-                config, search_str );
-        return 0;
+        node = node->parent;
     }
-    SMX_LOG_NET( h, debug, "no configuration loaded from '%s'", search_str );
     return -1;
 }
 
@@ -425,6 +913,155 @@ void smx_net_init( smx_net_t* h, int indegree, int outdegree )
         h->sig->out.ports[i] = NULL;
 }
 
+/*****************************************************************************/
+int smx_net_load_conf( smx_net_t* h, bson_iter_t* item, const char* path )
+{
+    int rc;
+    uint32_t len;
+    const uint8_t* nets;
+    const char* config;
+    smx_config_file_t* file;
+    bson_json_reader_t *reader;
+    bson_error_t error;
+    if( BSON_ITER_HOLDS_DOCUMENT( item ) )
+    {
+        bson_iter_document( item, &len, &nets );
+        h->static_conf = bson_new_from_data( nets, len );
+        h->conf = h->static_conf;
+        SMX_LOG_NET( h, notice, "load configuration '%s'", path );
+        return 0;
+    }
+    else if( BSON_ITER_HOLDS_UTF8( item ) )
+    {
+        config = bson_iter_utf8( item, NULL );
+        if( smx_config_net_props_get_file( h->rts->net_props, config, &file ) )
+        {
+            if( file->doc == NULL )
+            {
+                SMX_LOG_NET( h, error, "failed to load net config file '%s'",
+                        config );
+                return -1;
+            }
+            h->static_conf = file->doc;
+            h->has_shared_conf = true;
+            h->conf = h->static_conf;
+            SMX_LOG_NET( h, notice,
+                    "use shared config file '%s' of configuration item '%s'",
+                    config, path );
+            return 0;
+        }
+        reader = bson_json_reader_new_from_file( config, &error );
+        if( reader == NULL )
+        {
+            SMX_LOG_NET( h, error, "failed to load net config file '%s': %s",
+                    config, error.message );
+            return -1;
+        }
+
+        h->static_conf = bson_new();
+        rc = bson_json_reader_read( reader, h->static_conf, &error );
+        h->conf = h->static_conf;
+        if( rc < 0 )
+        {
+            SMX_LOG_NET( h, error,
+                    "failed to parse net config file '%s': %s",
+                    config, error.message );
+            return -1;
+        }
+
+        bson_json_reader_destroy( reader );
+        SMX_LOG_NET( h, notice,
+                "load config file '%s' of configuration item '%s'",
+                config, path );
+        return 0;
+    }
+    SMX_LOG_NET( h, debug, "no configuration loaded from '%s'", path );
+    return -1;
+}
+
+/*****************************************************************************/
+void smx_net_pace( smx_net_t* h )
+{
+    smx_net_pacer_t* pacer = h->pacer;
+    struct timespec ts;
+    uint64_t now, missed;
+    int rc;
+
+    now = smx_time_get_ns();
+    if( pacer->next == 0 )
+    {
+        // first release is immediate
+        pacer->next = now;
+    }
+
+    if( now < pacer->next )
+    {
+        smx_time_ns_to_timespec( pacer->next, &ts );
+        do {
+            rc = clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL );
+        } while( rc == EINTR );
+        if( rc != 0 )
+        {
+            SMX_LOG_NET( h, error, "failed to sleep until next release: %s",
+                    strerror( rc ) );
+        }
+        now = smx_time_get_ns();
+    }
+    else if( now - pacer->next >= pacer->period )
+    {
+        pacer->overruns++;
+        if( pacer->policy == SMX_NET_PACING_SKIP )
+        {
+            missed = ( now - pacer->next ) / pacer->period;
+            pacer->skipped += missed;
+            pacer->next += missed * pacer->period;
+            SMX_LOG_NET( h, info, "loop overrun, skipping %lu releases",
+                    missed );
+        }
+        else
+        {
+            SMX_LOG_NET( h, info, "loop overrun, catching up" );
+        }
+    }
+
+    smx_hist_record( &pacer->jitter, now > pacer->next ? now - pacer->next : 0 );
+    pacer->next += pacer->period;
+}
+
+/*****************************************************************************/
+int smx_net_queue_update( smx_net_t* h, smx_net_update_action_t action,
+        smx_channel_t* ch, bool terminate )
+{
+    smx_net_update_t* update;
+
+    if( h->has_thread && !h->is_running )
+    {
+        SMX_LOG_NET( h, error, "net is stopped, cannot apply topology"
+                " update" );
+        return -1;
+    }
+
+    update = smx_malloc( sizeof( struct smx_net_update_s ) );
+    if( update == NULL )
+        return -1;
+
+    update->action = action;
+    update->ch = ch;
+    update->terminate = terminate;
+    if( !h->is_running )
+    {
+        update->next = NULL;
+        smx_net_apply_update( h, update );
+        free( update );
+        return 0;
+    }
+
+    update->next = h->updates;
+    __atomic_store_n( &h->updates, update, __ATOMIC_RELEASE );
+    smx_net_wake( h );
+    return 0;
+}
+
 /*****************************************************************************/
 void smx_net_report_rate_warning( smx_net_t* h )
 {
@@ -458,13 +1095,21 @@ int smx_net_run( pthread_t* ths, int idx, void* box_impl( void* arg ), void* h )
     int min_fifo, max_fifo;
     char id_str[16];
 
-    if( idx >= SMX_MAX_NETS )
+    if( net->ce != NULL && !smx_ce_is_capable( net ) )
     {
-        SMX_LOG_MAIN( main, fatal, "thread count exeeds maximum %d", idx );
-        return -1;
+        SMX_LOG_NET( h, warn, "cyclic executive requires decoupled ports and"
+                " no source channels, running net in its own thread" );
+        smx_ce_leave( net->ce, net );
+        net->ce = NULL;
     }
 
     pthread_attr_init( &sched_attr );
+    if( net->rts->mem.stack_size > 0 && pthread_attr_setstacksize( &sched_attr,
+                net->rts->mem.stack_size ) != 0 )
+    {
+        SMX_LOG_NET( h, warn, "invalid stack size of %zu bytes, using the"
+                " default", net->rts->mem.stack_size );
+    }
     if( net->priority > 0 )
     {
         min_fifo = sched_get_priority_min( SCHED_FIFO );
@@ -483,18 +1128,83 @@ int smx_net_run( pthread_t* ths, int idx, void* box_impl( void* arg ), void* h )
         SMX_LOG_NET( h, debug, "creating RT thread of priority %d",
                 fifo_param.sched_priority );
     }
+    net->is_running = true;
+    net->has_thread = true;
     if( ( errno = pthread_create( &thread, &sched_attr, box_impl, h ) ) != 0 )
     {
+        net->is_running = false;
+        net->has_thread = false;
         SMX_LOG_NET( h, error, "failed to create a new thread: %s",
                 strerror( errno ) );
         return -1;
     }
+    net->thread = thread;
     sprintf( id_str, "smx_net_%d", net->id );
     pthread_setname_np( thread, id_str );
     ths[idx] = thread;
     return 0;
 }
 
+/*****************************************************************************/
+int smx_net_set_sched_dl( smx_net_t* h )
+{
+    int rc = -1;
+    struct smx_sched_attr_s attr;
+    smx_net_sched_dl_t* dl = h->sched_dl;
+
+    if( dl == NULL )
+        return -1;
+
+    memset( &attr, 0, sizeof( attr ) );
+    attr.size = sizeof( attr );
+    attr.sched_policy = SCHED_DEADLINE;
+    // a deadline thread may only create threads (e.g. the tf shard workers or
+    // the live configuration listener) if these do not inherit the policy
+    attr.sched_flags = SCHED_FLAG_RESET_ON_FORK;
+    attr.sched_runtime = dl->runtime;
+    attr.sched_deadline = dl->deadline;
+    attr.sched_period = dl->period;
+#ifdef SYS_sched_setattr
+    rc = syscall( SYS_sched_setattr, 0, &attr, 0 );
+#else
+    errno = ENOSYS;
+#endif
+    if( rc < 0 )
+    {
+        SMX_LOG_NET( h, warn, "failed to set SCHED_DEADLINE: %s, falling back"
+                " to SCHED_FIFO", strerror( errno ) );
+    }
+    else
+    {
+        dl->is_active = true;
+        SMX_LOG_NET( h, notice, "thread runs under SCHED_DEADLINE (runtime:"
+                " %lu ns, deadline: %lu ns, period: %lu ns)", dl->runtime,
+                dl->deadline, dl->period );
+    }
+
+    // release the loop of time-triggered nets at absolute deadlines
+    if( h->attr == NULL && h->pacer == NULL )
+    {
+        h->pacer = smx_net_alloc_pacer( SMX_NET_PACING_SKIP, dl->period );
+        if( h->pacer != NULL )
+        {
+            SMX_LOG_NET( h, notice, "release net loop every %lu ns",
+                    dl->period );
+        }
+    }
+
+    return dl->is_active ? 0 : -1;
+}
+
+/*****************************************************************************/
+void smx_net_signal_ready( smx_net_t* h )
+{
+    pthread_mutex_lock( &h->rts->init_mutex );
+    h->is_ready = true;
+    pthread_cond_broadcast( &h->rts->init_cv );
+    pthread_mutex_unlock( &h->rts->init_mutex );
+}
+
 /*****************************************************************************/
 int smx_net_source_add( smx_net_t* net, int len, struct timespec* timeout,
         int* idx )
@@ -541,6 +1251,49 @@ error:
     return -1;
 }
 
+/*****************************************************************************/
+int smx_net_source_add_fd( smx_net_t* net, int len, int fd, uint32_t events,
+        smx_source_fd_callback_t callback, int* idx )
+{
+    int src_idx;
+    smx_io_t* io;
+
+    if( callback == NULL || fd < 0 )
+    {
+        goto error;
+    }
+
+    if( smx_net_source_add( net, len, NULL, &src_idx ) < 0 )
+    {
+        goto error;
+    }
+
+    pthread_mutex_lock( &net->rts->net_mutex );
+    if( net->rts->io == NULL )
+    {
+        net->rts->io = smx_io_create();
+    }
+    io = net->rts->io;
+    pthread_mutex_unlock( &net->rts->net_mutex );
+
+    if( smx_io_add( io, net, src_idx, fd, events, callback ) < 0 )
+    {
+        goto error;
+    }
+
+    if( idx != NULL )
+    {
+        *idx = src_idx;
+    }
+    SMX_LOG( net, notice, "added fd source %d at index %d", fd, src_idx );
+
+    return 0;
+
+error:
+    SMX_LOG( net, error, "failed to add fd source %d", fd );
+    return -1;
+}
+
 /*****************************************************************************/
 int smx_net_source_disable( smx_net_t* net, int idx )
 {
@@ -672,9 +1425,14 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
         void cleanup_shared( void* ), const char* shared_state_key )
 {
     double elapsed_wall;
+    uint64_t loop_start = 0, impl_start, impl_end;
+    long minflt = 0, majflt = 0, minflt_end, majflt_end;
     int state = SMX_NET_CONTINUE;
     int rc;
-    int i, tid;
+    int tid;
+    bool has_conf_th = false;
+    bool is_interrupted = false;
+    pthread_t conf_th;
     smx_channel_t* conf_port = NULL;
     smx_channel_err_t c_err;
     smx_msg_t* msg;
@@ -686,11 +1444,12 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
         return NULL;
     }
 
+    rcu_register_thread();
+
     if( h->is_disabled )
     {
         SMX_LOG_NET( h, notice, "net was disabled through configuration" );
-        pthread_barrier_wait( &h->rts->pre_init_done );
-        pthread_barrier_wait( &h->rts->init_done );
+        smx_net_signal_ready( h );
         goto smx_terminate_net;
     }
 
@@ -709,6 +1468,17 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
                 getpriority( PRIO_PROCESS, tid ) );
     }
 
+    if( h->sched_dl != NULL && h->ce == NULL )
+    {
+        smx_net_set_sched_dl( h );
+    }
+
+    if( h->priority > 0 && h->rts->mem.is_locked )
+    {
+        smx_mem_prefault_stack( h->rts->mem.stack_size );
+        smx_mem_get_faults( &minflt, &majflt );
+    }
+
     if( h->shared_state_key == NULL )
     {
         h->shared_state_key = shared_state_key;
@@ -720,52 +1490,31 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
         if( h->static_conf == NULL )
         {
             SMX_LOG_NET( h, error, "no static net configuration available" );
-            pthread_barrier_wait( &h->rts->pre_init_done );
-            pthread_barrier_wait( &h->rts->init_done );
+            smx_net_signal_ready( h );
             goto smx_terminate_net;
         }
 
-        pthread_mutex_lock( &h->rts->net_mutex );
-        for( i = 0; i < h->rts->shared_state_cnt; i++ )
+        rc = smx_rts_shared_state_get_or_init( h->rts, h->shared_state_key,
+                h, init_shared, cleanup_shared, &h->shared_state );
+        if( rc < 0 )
         {
-            if( strcmp( h->rts->shared_state[i]->key, h->shared_state_key ) == 0 )
-            {
-                h->shared_state = h->rts->shared_state[i]->state;
-                SMX_LOG_NET( h, notice, "using already allocated shared state"
-                        " with key '%s'", h->shared_state_key );
-                break;
-            }
+            SMX_LOG_NET( h, error, "pre initialisation of net failed" );
+            smx_net_signal_ready( h );
+            goto smx_terminate_net;
         }
-        if( h->shared_state == NULL )
-        {
-            h->rts->shared_state[h->rts->shared_state_cnt] = smx_malloc(
-                    sizeof( struct smx_rts_shared_state_s ) );
-            h->rts->shared_state[h->rts->shared_state_cnt]->key =
-                h->shared_state_key;
-            h->rts->shared_state[h->rts->shared_state_cnt]->cleanup =
-                cleanup_shared;
-            h->rts->shared_state[h->rts->shared_state_cnt]->state = NULL;
-            rc = init_shared( h, &h->shared_state );
-            h->rts->shared_state[h->rts->shared_state_cnt]->state =
-                h->shared_state;
-            SMX_LOG_NET( h, notice, "shared state allocated with key '%s' at"
-                    " position '%d'", h->shared_state_key,
-                    h->rts->shared_state_cnt );
-            h->rts->shared_state_cnt++;
-            if( rc < 0 )
-            {
-                SMX_LOG_NET( h, error, "pre initialisation of net failed" );
-                pthread_barrier_wait( &h->rts->pre_init_done );
-                pthread_barrier_wait( &h->rts->init_done );
-                goto smx_terminate_net;
-            }
+        else if( rc > 0 )
+        {
+            SMX_LOG_NET( h, notice, "using already allocated shared state"
+                    " with key '%s'", h->shared_state_key );
+        }
+        else
+        {
+            SMX_LOG_NET( h, notice, "shared state allocated with key '%s'",
+                    h->shared_state_key );
         }
-        pthread_mutex_unlock( &h->rts->net_mutex );
         SMX_LOG_NET( h, notice, "pre init done" );
     }
 
-    pthread_barrier_wait( &h->rts->pre_init_done );
-
     if( h->conf_port_name != NULL )
     {
         conf_port = smx_get_channel_by_name( h->sig->in.ports,
@@ -775,7 +1524,7 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
             SMX_LOG_NET( h, error,
                     "dynamic configuration port '%s' does not exist",
                     h->conf_port_name );
-            pthread_barrier_wait( &h->rts->init_done );
+            smx_net_signal_ready( h );
             goto smx_terminate_net;
         }
         SMX_LOG_NET( h, notice, "awaiting dynamic configuration..." );
@@ -792,7 +1541,7 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
                         " port '%s' timed out", h->conf_port_name );
             }
             SMX_LOG_NET( h, error, "failed to read dynamic configuration" );
-            pthread_barrier_wait( &h->rts->init_done );
+            smx_net_signal_ready( h );
             goto smx_terminate_net;
         }
         else
@@ -801,7 +1550,7 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
             if( h->dyn_conf == NULL )
             {
                 SMX_LOG( h, error, "unable to parse dynamic configuration" );
-                pthread_barrier_wait( &h->rts->init_done );
+                smx_net_signal_ready( h );
                 goto smx_terminate_net;
             }
             SMX_LOG( h, debug, "received dynamic configuration: %s",
@@ -816,7 +1565,7 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
     if( h->conf == NULL )
     {
         SMX_LOG_NET( h, error, "no net configuration available" );
-        pthread_barrier_wait( &h->rts->init_done );
+        smx_net_signal_ready( h );
         goto smx_terminate_net;
     }
 
@@ -825,26 +1574,72 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
     if( rc < 0 )
     {
         SMX_LOG_NET( h, error, "initialisation of net failed" );
-        pthread_barrier_wait( &h->rts->init_done );
+        smx_net_signal_ready( h );
         goto smx_terminate_net;
     }
 
     SMX_LOG_NET( h, notice, "init done" );
-    pthread_barrier_wait( &h->rts->init_done );
+    smx_net_signal_ready( h );
+    smx_net_wait_ready( h, conf_port );
+
+    if( conf_port != NULL && h->has_live_conf )
+    {
+        if( conf_port->type == SMX_FIFO_D || conf_port->type == SMX_D_FIFO_D )
+        {
+            SMX_LOG_NET( h, warn, "live configuration is not supported on"
+                    " decoupled port '%s', ignoring", h->conf_port_name );
+        }
+        else
+        {
+            rc = pthread_create( &conf_th, NULL, smx_net_conf_listen, h );
+            if( rc != 0 )
+            {
+                SMX_LOG_NET( h, error, "failed to start configuration"
+                        " listener: %s", strerror( rc ) );
+            }
+            else
+            {
+                has_conf_th = true;
+            }
+        }
+    }
 
     clock_gettime( CLOCK_MONOTONIC, &h->start_wall );
     h->last_count_wall.tv_nsec = h->start_wall.tv_nsec;
     h->last_count_wall.tv_sec = h->start_wall.tv_sec;
+    h->stats->last_dump = smx_time_timespec_to_ns( &h->start_wall );
     SMX_LOG_NET( h, notice, "start net" );
+    if( h->ce != NULL )
+    {
+        // the loop is executed by the cyclic executive
+        if( smx_ce_join( h->ce, h, impl ) == 0 )
+            state = SMX_NET_END;
+        else
+        {
+            SMX_LOG_NET( h, warn, "execute net in its own thread" );
+            h->ce = NULL;
+        }
+    }
     while( state == SMX_NET_CONTINUE )
     {
-        smx_profiler_log_net( h, SMX_PROFILER_ACTION_NET_START );
-        h->count++;
-        SMX_LOG_NET( h, info, "start net loop %ld", h->count );
-        if( ( h->expected_rate > 0 )
-                && ( ( h->count % h->expected_rate ) == 0 ) )
+        if( __atomic_load_n( &h->updates, __ATOMIC_ACQUIRE ) != NULL
+                && smx_net_apply_updates( h ) == SMX_NET_END )
         {
-            smx_net_report_rate_warning( h );
+            break;
+        }
+        if( !is_interrupted )
+        {
+            if( h->pacer != NULL )
+            {
+                smx_net_pace( h );
+            }
+            loop_start = smx_time_get_ns();
+            smx_profiler_log_net( h, SMX_PROFILER_ACTION_NET_START );
+        }
+        is_interrupted = false;
+        if( has_conf_th )
+        {
+            smx_net_apply_conf( h );
         }
         // only block for normal nets
         if( h->attr == NULL )
@@ -858,7 +1653,8 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
                 }
                 if( rc == 0 )
                 {
-                    rc = smx_channel_await( h, h->sig->source.items[i].port );
+                    rc = smx_channel_await_update( h,
+                            h->sig->source.items[i].port );
                     if( rc != SMX_CHANNEL_ERR_OPEN
                             && rc != SMX_CHANNEL_ERR_TIMEOUT
                             && rc < 0 )
@@ -871,7 +1667,7 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
             {
                 if( h->sig->in.ports[i] != conf_port )
                 {
-                    rc = smx_channel_await( h, h->sig->in.ports[i] );
+                    rc = smx_channel_await_update( h, h->sig->in.ports[i] );
                     if( rc != SMX_CHANNEL_ERR_OPEN && rc != SMX_CHANNEL_ERR_TIMEOUT
                             && rc < 0 )
                     {
@@ -879,26 +1675,95 @@ void* smx_net_start_routine_with_shared_state( smx_net_t* h,
                     }
                 }
             }
+            if( smx_net_has_updates( h ) )
+            {
+                // the wait was interrupted to apply a topology or configuration
+                // update, this is not a new iteration
+                is_interrupted = true;
+                continue;
+            }
+        }
+        h->count++;
+        SMX_LOG_NET( h, info, "start net loop %ld", h->count );
+        if( ( h->expected_rate > 0 )
+                && ( ( h->count % h->expected_rate ) == 0 ) )
+        {
+            smx_net_report_rate_warning( h );
         }
         smx_profiler_log_net( h, SMX_PROFILER_ACTION_NET_START_IMPL );
+        impl_start = smx_time_get_ns();
         state = impl( h, h->state );
+        impl_end = smx_time_get_ns();
         smx_profiler_log_net( h, SMX_PROFILER_ACTION_NET_END_IMPL );
+        smx_hist_record( &h->stats->await, impl_start - loop_start );
+        smx_hist_record( &h->stats->impl, impl_end - impl_start );
+        smx_hist_record( &h->stats->loop, impl_end - loop_start );
+        if( h->stats->dump_period > 0
+                && impl_end - h->stats->last_dump >= h->stats->dump_period )
+        {
+            smx_net_stats_dump( h );
+            h->stats->last_dump = impl_end;
+        }
         state = smx_net_update_state( h, state );
         smx_profiler_log_net( h, SMX_PROFILER_ACTION_NET_END );
     }
 
 smx_terminate_net:
+    // no update is queued once the net is stopped, apply the remaining ones
+    pthread_mutex_lock( &h->rts->net_mutex );
+    h->is_running = false;
+    pthread_mutex_unlock( &h->rts->net_mutex );
+    smx_net_apply_updates( h );
+    if( h->ce != NULL )
+    {
+        smx_ce_leave( h->ce, h );
+    }
     clock_gettime( CLOCK_MONOTONIC, &h->end_wall );
+    smx_io_remove_net( h->rts->io, h );
     smx_net_terminate( h );
+    if( has_conf_th )
+    {
+        smx_channel_terminate_source( conf_port );
+        pthread_join( conf_th, NULL );
+    }
     SMX_LOG_NET( h, notice, "cleanup net" );
     cleanup( h, h->state );
     elapsed_wall = ( h->end_wall.tv_sec - h->start_wall.tv_sec );
     elapsed_wall += ( h->end_wall.tv_nsec - h->start_wall.tv_nsec ) / 1000000000.0;
     SMX_LOG_NET( h, notice, "terminate net (loop count: %ld, loop rate: %d, wall time: %f)",
             h->count, ( int )( h->count / elapsed_wall ), elapsed_wall );
+    if( h->count > 0 )
+    {
+        smx_net_stats_dump( h );
+    }
+    if( h->pacer != NULL && h->count > 0 )
+    {
+        SMX_LOG_NET( h, notice, "rate pacing: %lu overruns, %lu skipped"
+                " releases", h->pacer->overruns, h->pacer->skipped );
+        smx_hist_log( h->cat, "release jitter", &h->pacer->jitter );
+    }
+    if( h->priority > 0 && h->rts->mem.is_locked && h->count > 0
+            && smx_mem_get_faults( &minflt_end, &majflt_end ) == 0 )
+    {
+        SMX_LOG_NET( h, notice, "page faults after start: %ld minor, %ld"
+                " major", minflt_end - minflt, majflt_end - majflt );
+    }
+    rcu_unregister_thread();
     return NULL;
 }
 
+/*****************************************************************************/
+void smx_net_stats_dump( smx_net_t* h )
+{
+    if( h == NULL || h->stats == NULL )
+        return;
+
+    SMX_LOG_NET( h, notice, "loop statistics after %ld loops", h->count );
+    smx_hist_log( h->cat, "await time", &h->stats->await );
+    smx_hist_log( h->cat, "impl time", &h->stats->impl );
+    smx_hist_log( h->cat, "loop time", &h->stats->loop );
+}
+
 /*****************************************************************************/
 void smx_net_terminate( smx_net_t* h )
 {
@@ -986,6 +1851,56 @@ int smx_net_update_state( smx_net_t* h, int state )
     return SMX_NET_CONTINUE;
 }
 
+/*****************************************************************************/
+static void smx_net_wait_ready_peer( smx_net_t* h, smx_net_t* peer )
+{
+    if( peer == NULL || peer == h )
+        return;
+
+    while( !peer->is_ready )
+    {
+        SMX_LOG_NET( h, debug, "waiting for neighbour %s(%d) to be ready",
+                peer->name, peer->id );
+        pthread_cond_wait( &h->rts->init_cv, &h->rts->init_mutex );
+    }
+}
+
+/*****************************************************************************/
+void smx_net_wait_ready( smx_net_t* h, smx_channel_t* conf_port )
+{
+    int i;
+    smx_channel_t* ch;
+    smx_net_t* peer;
+    uint64_t start = smx_time_get_ns();
+
+    pthread_mutex_lock( &h->rts->init_mutex );
+    for( i = 0; i < h->sig->in.count; i++ )
+    {
+        ch = h->sig->in.ports[i];
+        if( ch == NULL || ch == conf_port )
+            continue;
+        smx_net_wait_ready_peer( h, ch->sink->net );
+    }
+    for( i = 0; i < h->sig->out.count; i++ )
+    {
+        ch = h->sig->out.ports[i];
+        if( ch == NULL )
+            continue;
+        peer = ch->source->net;
+        if( peer != NULL && peer->conf_port_name != NULL
+                && strcmp( ch->name, peer->conf_port_name ) == 0 )
+        {
+            /* the peer requires our messages to initialise */
+            continue;
+        }
+        smx_net_wait_ready_peer( h, peer );
+    }
+    pthread_mutex_unlock( &h->rts->init_mutex );
+
+    SMX_LOG_NET( h, notice, "neighbours ready after %.3f ms",
+            ( smx_time_get_ns() - start ) / 1000000.0 );
+}
+
 /*****************************************************************************/
 void smx_net_wait_end( pthread_t th )
 {
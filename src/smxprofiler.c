@@ -130,3 +130,26 @@ void smx_profiler_log_net( smx_net_t* net, smx_profiler_action_net_t action )
             break;
     }
 }
+
+#define tracepoint_tf(action)\
+    tracepoint(smx_lttng, action, net->id, net->name, val)
+
+/*****************************************************************************/
+void smx_profiler_log_tf( smx_net_t* net, smx_profiler_action_tf_t action,
+        uint64_t val )
+{
+    if( net == NULL || !net->has_profiler )
+        return;
+    switch(action)
+    {
+        case SMX_PROFILER_ACTION_TF_WAKEUP:
+            tracepoint_tf(tf_wakeup);
+            break;
+        case SMX_PROFILER_ACTION_TF_MISS:
+            tracepoint_tf(tf_miss);
+            break;
+        case SMX_PROFILER_ACTION_TF_PROPAGATE:
+            tracepoint_tf(tf_propagate);
+            break;
+    }
+}
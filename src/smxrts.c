@@ -5,6 +5,9 @@
  * The runtime system library for Streamix
  */
 
+#include <dlfcn.h>
+#include <unistd.h>
+#include <urcu.h>
 #include "smxrts.h"
 
 #define LIBZLOG_VERSION "1.2.14"
@@ -16,20 +19,26 @@
 /*****************************************************************************/
 void smx_program_cleanup( smx_rts_t* rts )
 {
-    int i;
     double elapsed_wall;
-    for( i = 0; i < rts->shared_state_cnt; i++ )
-    {
-        rts->shared_state[i]->cleanup( rts->shared_state[i]->state );
-        free( rts->shared_state[i] );
-    }
+    smx_rts_topology_cleanup( rts );
+    smx_ce_destroy( rts );
+    smx_io_destroy( rts->io );
+    smx_timer_wheel_cleanup();
+    smx_rts_shared_state_destroy( rts->shared_state );
+    smx_sync_cleanup( rts );
     pthread_mutex_destroy( &rts->net_mutex );
+    pthread_mutex_destroy( &rts->ce_mutex );
+    smx_config_net_props_destroy( rts->net_props );
     bson_destroy( rts->conf );
     if( rts->args != NULL )
     {
         bson_destroy( rts->args );
     }
-    pthread_barrier_destroy( &rts->init_done );
+    pthread_mutex_destroy( &rts->init_mutex );
+    pthread_cond_destroy( &rts->init_cv );
+    free( rts->ths );
+    free( rts->chs );
+    free( rts->nets );
     clock_gettime( CLOCK_MONOTONIC, &rts->end_wall );
     elapsed_wall = ( rts->end_wall.tv_sec - rts->start_wall.tv_sec );
     elapsed_wall += ( rts->end_wall.tv_nsec - rts->start_wall.tv_nsec) / 1000000000.0;
@@ -39,6 +48,14 @@ void smx_program_cleanup( smx_rts_t* rts )
     exit( EXIT_SUCCESS );
 }
 
+/*****************************************************************************/
+void smx_program_init_abort( smx_rts_t* rts )
+{
+    SMX_LOG_MAIN( main, fatal, "failed to create the topology, aborting" );
+    smx_log_cleanup();
+    exit( EXIT_FAILURE );
+}
+
 /*****************************************************************************/
 smx_rts_t* smx_program_init( const char* app_conf, const char* log_conf,
         const char** app_conf_maps, int app_conf_map_count,
@@ -115,9 +132,29 @@ smx_rts_t* smx_program_init( const char* app_conf, const char* log_conf,
         goto error;
     }
 
-    rts->shared_state_cnt = 0;
+    rts->shared_state = smx_rts_shared_state_create();
+    if( rts->shared_state == NULL )
+    {
+        SMX_LOG_MAIN( main, fatal, "cannot create shared state registry" );
+        free( rts );
+        goto error;
+    }
+    rts->seqlocks = NULL;
+    rts->rcu_ptrs = NULL;
+    rts->io = NULL;
+    rts->tf_epoch = 0;
+    rts->ce = NULL;
+    rts->dyn_nets = NULL;
+    rts->dyn_chs = NULL;
+    rts->dyn_ch_cnt = 0;
+    rts->dyn_ch_len = 0;
     rts->ch_cnt = 0;
     rts->net_cnt = 0;
+    rts->ch_len = 0;
+    rts->net_len = 0;
+    rts->ths = NULL;
+    rts->chs = NULL;
+    rts->nets = NULL;
     rts->start_wall.tv_sec = 0;
     rts->start_wall.tv_nsec = 0;
     rts->end_wall.tv_sec = 0;
@@ -125,18 +162,39 @@ smx_rts_t* smx_program_init( const char* app_conf, const char* log_conf,
     rts->conf = bson_copy( &tgt );
     rts->args = NULL;
 
+    rts->net_props = smx_config_net_props_create( rts->conf );
+    if( rts->net_props == NULL || smx_config_net_props_load_files(
+                rts->net_props, sysconf( _SC_NPROCESSORS_ONLN ) ) < 0 )
+    {
+        smx_config_net_props_destroy( rts->net_props );
+        smx_rts_shared_state_destroy( rts->shared_state );
+        bson_destroy( rts->conf );
+        free( rts );
+        goto error;
+    }
+
     rc = smx_program_init_args( arg_str, arg_file, name, rts );
     if( rc < 0 )
     {
+        smx_config_net_props_destroy( rts->net_props );
+        smx_rts_shared_state_destroy( rts->shared_state );
         bson_destroy( rts->conf );
         free( rts );
         goto error;
     }
 
+    if( smx_mem_init( rts ) < 0 )
+    {
+        SMX_LOG_MAIN( main, warn, "continue without real-time memory mode" );
+    }
+
     pthread_mutexattr_init( &mutexattr_prioinherit );
     pthread_mutexattr_setprotocol( &mutexattr_prioinherit,
             PTHREAD_PRIO_INHERIT );
     pthread_mutex_init( &rts->net_mutex, &mutexattr_prioinherit );
+    pthread_mutex_init( &rts->ce_mutex, &mutexattr_prioinherit );
+    pthread_mutex_init( &rts->init_mutex, &mutexattr_prioinherit );
+    pthread_cond_init( &rts->init_cv, NULL );
     clock_gettime( CLOCK_MONOTONIC, &rts->start_wall );
 
     SMX_LOG_MAIN( main, notice, "using libsmxrts version: %s",
@@ -336,16 +394,1288 @@ error:
 /*****************************************************************************/
 void smx_program_init_run( smx_rts_t* rts )
 {
-    SMX_LOG_MAIN( main, notice, "waiting for all %d nets to finish"
-            " initialisation", rts->net_cnt );
-    if( pthread_barrier_init( &rts->pre_init_done, NULL, rts->net_cnt ) != 0 )
+    SMX_LOG_MAIN( main, notice, "resolved net properties with %lu lookups in"
+            " %.3f ms (index built in %.3f ms, config files loaded in"
+            " %.3f ms)", rts->net_props->lookup_cnt,
+            rts->net_props->resolve_time / 1000000.0,
+            rts->net_props->index_time / 1000000.0,
+            rts->net_props->load_time / 1000000.0 );
+    SMX_LOG_MAIN( main, notice, "%d nets start as soon as their neighbours"
+            " are initialised", rts->net_cnt );
+}
+
+/*****************************************************************************/
+static int smx_rts_resize( void** table, int len, int new_len,
+        size_t item_size )
+{
+    char* items = realloc( *table, new_len * item_size );
+    if( items == NULL )
+    {
+        SMX_LOG_MAIN( main, fatal, "failed to resize topology table to %d"
+                " items", new_len );
+        return -1;
+    }
+    memset( items + len * item_size, 0, ( new_len - len ) * item_size );
+    *table = items;
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_resize_nets( smx_rts_t* rts, int net_len )
+{
+    if( smx_rts_resize( ( void** )&rts->nets, rts->net_len, net_len,
+                sizeof( smx_net_t* ) ) < 0
+            || smx_rts_resize( ( void** )&rts->ths, rts->net_len, net_len,
+                sizeof( pthread_t ) ) < 0 )
+        return -1;
+    rts->net_len = net_len;
+    return 0;
+}
+
+/*****************************************************************************/
+int smx_program_init_topology( smx_rts_t* rts, int net_count, int ch_count )
+{
+    if( net_count > rts->net_len && smx_rts_resize_nets( rts, net_count ) < 0 )
+        return -1;
+    if( ch_count > rts->ch_len )
+    {
+        if( smx_rts_resize( ( void** )&rts->chs, rts->ch_len, ch_count,
+                    sizeof( smx_channel_t* ) ) < 0 )
+            return -1;
+        rts->ch_len = ch_count;
+    }
+    SMX_LOG_MAIN( main, notice, "topology tables sized for %d nets and %d"
+            " channels", rts->net_len, rts->ch_len );
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_init_doc( bson_iter_t* iter, bson_t* doc )
+{
+    const uint8_t* data;
+    uint32_t len;
+
+    if( !BSON_ITER_HOLDS_DOCUMENT( iter ) )
+        return -1;
+    bson_iter_document( iter, &len, &data );
+    return bson_init_static( doc, data, len ) ? 0 : -1;
+}
+
+/*****************************************************************************/
+static smx_channel_t** smx_rts_topology_get_channel( smx_hmap_t* chs,
+        bson_iter_t* iter, const char* net_name )
+{
+    smx_channel_t** slot;
+
+    if( !BSON_ITER_HOLDS_UTF8( iter ) )
+    {
+        SMX_LOG_MAIN( main, error, "channel names of net '%s' must be strings",
+                net_name );
+        return NULL;
+    }
+    slot = smx_hmap_get( chs, bson_iter_utf8( iter, NULL ) );
+    if( slot == NULL )
+    {
+        SMX_LOG_MAIN( main, error, "net '%s' refers to unknown channel '%s'",
+                net_name, bson_iter_utf8( iter, NULL ) );
+    }
+    return slot;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_count( bson_t* desc, const char* key )
+{
+    bson_iter_t iter;
+    bson_iter_t child;
+    int count = 0;
+
+    if( bson_iter_init( &iter, desc ) && bson_iter_find_descendant( &iter,
+                key, &child ) && BSON_ITER_HOLDS_ARRAY( &child )
+            && bson_iter_recurse( &child, &iter ) )
+    {
+        while( bson_iter_next( &iter ) )
+            count++;
+    }
+    return count;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_get_ports( bson_t* desc, const char* key,
+        const char* net_name, bson_iter_t* iter )
+{
+    bson_iter_t child;
+
+    if( !bson_iter_init( iter, desc ) || !bson_iter_find_descendant( iter,
+                key, &child ) )
+        return 1;
+
+    if( !BSON_ITER_HOLDS_ARRAY( &child ) || !bson_iter_recurse( &child,
+                iter ) )
+    {
+        SMX_LOG_MAIN( main, error, "'%s' of net '%s' must be an array", key,
+                net_name );
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_check_ports( bson_t* desc, const char* key,
+        smx_hmap_t* chs, const char* net_name )
+{
+    int rc;
+    bson_iter_t iter;
+
+    rc = smx_rts_topology_get_ports( desc, key, net_name, &iter );
+    if( rc != 0 )
+        return ( rc < 0 ) ? -1 : 0;
+
+    while( bson_iter_next( &iter ) )
+    {
+        if( smx_rts_topology_get_channel( chs, &iter, net_name ) == NULL )
+            return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_connect( smx_net_t* net, bson_t* desc,
+        const char* key, smx_hmap_t* chs,
+        int connect( smx_net_t*, smx_channel_t* ) )
+{
+    int rc;
+    bson_iter_t iter;
+    smx_channel_t** slot;
+
+    rc = smx_rts_topology_get_ports( desc, key, net->name, &iter );
+    if( rc != 0 )
+        return ( rc < 0 ) ? -1 : 0;
+
+    while( bson_iter_next( &iter ) )
+    {
+        slot = smx_rts_topology_get_channel( chs, &iter, net->name );
+        if( slot == NULL || connect( net, *slot ) < 0 )
+            return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_get_tf_rate( bson_t* desc, int pair,
+        const char* net_name, int* sec, int* nsec, int* phase_sec,
+        int* phase_nsec )
+{
+    int i;
+    char key[100];
+    bson_iter_t iter;
+    bson_iter_t child;
+    const char* names[] = { "sec", "nsec", "phase_sec", "phase_nsec" };
+    int* vals[] = { sec, nsec, phase_sec, phase_nsec };
+
+    *sec = 0;
+    *nsec = 0;
+    *phase_sec = 0;
+    *phase_nsec = 0;
+    snprintf( key, sizeof( key ), "tf.rates.%d", pair );
+    if( !bson_iter_init( &iter, desc ) || !bson_iter_find_descendant( &iter,
+                key, &child ) )
+    {
+        // the port pair uses the period of the temporal firewall
+        return 1;
+    }
+    if( !BSON_ITER_HOLDS_DOCUMENT( &child ) )
+    {
+        SMX_LOG_MAIN( main, error, "rate %d of temporal firewall '%s' must be"
+                " an object", pair, net_name );
+        return -1;
+    }
+
+    for( i = 0; i < 4; i++ )
+    {
+        snprintf( key, sizeof( key ), "tf.rates.%d.%s", pair, names[i] );
+        switch( smx_config_init_int( desc, key, vals[i] ) )
+        {
+            case SMX_CONFIG_ERROR_NO_ERROR:
+                break;
+            case SMX_CONFIG_ERROR_NO_VALUE:
+                // only the period is mandatory
+                if( i == 0 )
+                {
+                    SMX_LOG_MAIN( main, error, "rate %d of temporal firewall"
+                            " '%s' requires 'sec'", pair, net_name );
+                    return -1;
+                }
+                break;
+            default:
+                SMX_LOG_MAIN( main, error, "'%s' of rate %d of temporal"
+                        " firewall '%s' must be an integer", names[i], pair,
+                        net_name );
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_check_tf( bson_t* desc, smx_hmap_t* chs,
+        const char* net_name )
+{
+    int sec, nsec, phase_sec, phase_nsec;
+    int pair = 0;
+    bson_iter_t i_in;
+    bson_iter_t i_out;
+
+    if( smx_rts_topology_get_ports( desc, "in", net_name, &i_in ) != 0
+            || smx_rts_topology_get_ports( desc, "out", net_name,
+                &i_out ) != 0 )
+    {
+        SMX_LOG_MAIN( main, error, "temporal firewall '%s' requires an 'in'"
+                " and an 'out' array", net_name );
+        return -1;
+    }
+
+    // the n-th input channel is propagated to the n-th output channel
+    while( bson_iter_next( &i_in ) )
+    {
+        if( !bson_iter_next( &i_out ) )
+        {
+            SMX_LOG_MAIN( main, error, "temporal firewall '%s' has more inputs"
+                    " than outputs", net_name );
+            return -1;
+        }
+        if( smx_rts_topology_get_channel( chs, &i_in, net_name ) == NULL
+                || smx_rts_topology_get_channel( chs, &i_out,
+                    net_name ) == NULL
+                || smx_rts_topology_get_tf_rate( desc, pair, net_name, &sec,
+                    &nsec, &phase_sec, &phase_nsec ) < 0 )
+            return -1;
+        pair++;
+    }
+    if( bson_iter_next( &i_out ) )
+    {
+        SMX_LOG_MAIN( main, error, "temporal firewall '%s' has more outputs"
+                " than inputs", net_name );
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_connect_tf( smx_net_t* net, bson_t* desc,
+        smx_hmap_t* chs )
+{
+    bson_iter_t i_in;
+    bson_iter_t i_out;
+    int sec = 0;
+    int nsec = 0;
+    int phase_sec, phase_nsec;
+    int pair = 0;
+    int rc;
+    smx_channel_t* ch_in;
+    smx_channel_t* ch_out;
+
+    smx_config_init_int( desc, "tf.sec", &sec );
+    smx_config_init_int( desc, "tf.nsec", &nsec );
+    smx_net_init_tf( net, sec, nsec );
+    if( net->attr == NULL )
+        return -1;
+
+    // the description was checked by smx_rts_topology_check_tf()
+    smx_rts_topology_get_ports( desc, "in", net->name, &i_in );
+    smx_rts_topology_get_ports( desc, "out", net->name, &i_out );
+    while( bson_iter_next( &i_in ) && bson_iter_next( &i_out ) )
+    {
+        ch_in = *smx_rts_topology_get_channel( chs, &i_in, net->name );
+        ch_out = *smx_rts_topology_get_channel( chs, &i_out, net->name );
+        if( ch_in->source->net != NULL || ch_out->sink->net != NULL )
+        {
+            SMX_LOG_MAIN( main, error, "channels of temporal firewall '%s' are"
+                    " already connected", net->name );
+            return -1;
+        }
+        rc = smx_rts_topology_get_tf_rate( desc, pair, net->name, &sec, &nsec,
+                &phase_sec, &phase_nsec );
+        if( rc < 0 )
+            return -1;
+        else if( rc == 0 )
+            smx_connect_tf_rate( net, ch_in, ch_out, sec, nsec, phase_sec,
+                    phase_nsec );
+        else
+            smx_connect_tf( net, ch_in, ch_out );
+        pair++;
+    }
+    smx_net_finalize_tf( net );
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_get_channel_type( bson_t* desc, const char* name,
+        smx_channel_type_t* type )
+{
+    const char* type_name;
+
+    type_name = smx_config_get_string( desc, "type", NULL );
+    if( type_name == NULL || strcmp( type_name, "fifo" ) == 0 )
+        *type = SMX_FIFO;
+    else if( strcmp( type_name, "fifo_d" ) == 0 )
+        *type = SMX_FIFO_D;
+    else if( strcmp( type_name, "d_fifo" ) == 0 )
+        *type = SMX_D_FIFO;
+    else if( strcmp( type_name, "d_fifo_d" ) == 0 )
+        *type = SMX_D_FIFO_D;
+    else
+    {
+        SMX_LOG_MAIN( main, error, "unknown type '%s' of channel '%s'",
+                type_name, name );
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_check_channel( bson_t* desc, smx_hmap_t* chs,
+        smx_channel_t** slot )
+{
+    const char* name;
+    smx_channel_type_t type;
+
+    name = smx_config_get_string( desc, "name", NULL );
+    if( name == NULL )
+    {
+        SMX_LOG_MAIN( main, error, "channel description without 'name'" );
+        return -1;
+    }
+    if( smx_rts_topology_get_channel_type( desc, name, &type ) < 0 )
+        return -1;
+
+    // the slot is filled once the channel is created
+    *slot = NULL;
+    if( smx_hmap_put( chs, name, slot ) < 0 )
+    {
+        SMX_LOG_MAIN( main, error, "duplicate channel name '%s'", name );
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+static smx_channel_t* smx_rts_topology_load_channel( smx_rts_t* rts,
+        bson_t* desc )
+{
+    int len = 1;
+    int iats = 0;
+    int iatns = 0;
+    bool has_guard = false;
+    const char* name;
+    smx_channel_type_t type = SMX_FIFO;
+    smx_channel_t* ch;
+
+    // the description was checked by smx_rts_topology_check_channel()
+    name = smx_config_get_string( desc, "name", NULL );
+    smx_config_init_int( desc, "len", &len );
+    smx_rts_topology_get_channel_type( desc, name, &type );
+
+    ch = smx_rts_channel_create( rts, name, len, type );
+    if( ch == NULL )
+        return NULL;
+
+    if( smx_config_init_int( desc, "guard.iat_sec", &iats ) == 0 )
+        has_guard = true;
+    if( smx_config_init_int( desc, "guard.iat_nsec", &iatns ) == 0 )
+        has_guard = true;
+    if( has_guard )
+        smx_connect_guard( ch, smx_guard_create( iats, iatns, ch ) );
+
+    return ch;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_check_net( bson_t* desc, smx_hmap_t* chs,
+        void* handle, void* ( **start_routine )( void* ) )
+{
+    char symbol[1000];
+    const char* name;
+    const char* impl;
+
+    name = smx_config_get_string( desc, "name", NULL );
+    impl = smx_config_get_string( desc, "impl", NULL );
+    if( name == NULL || impl == NULL )
+    {
+        SMX_LOG_MAIN( main, error, "net description without 'name' or"
+                " 'impl'" );
+        return -1;
+    }
+
+    snprintf( symbol, sizeof( symbol ), "start_routine_%s", impl );
+    *start_routine = dlsym( handle, symbol );
+    if( *start_routine == NULL )
+    {
+        SMX_LOG_MAIN( main, error, "unable to resolve '%s' of net '%s': %s"
+                " (is the application linked with -rdynamic?)", symbol, name,
+                dlerror() );
+        return -1;
+    }
+
+    if( strcmp( impl, "smx_tf" ) == 0 )
+        return smx_rts_topology_check_tf( desc, chs, name );
+
+    if( smx_rts_topology_check_ports( desc, "in", chs, name ) < 0
+            || smx_rts_topology_check_ports( desc, "out", chs, name ) < 0 )
+        return -1;
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_topology_load_net( smx_rts_t* rts, bson_t* desc,
+        smx_hmap_t* chs, smx_net_t** net )
+{
+    int prio = 0;
+    int rc;
+    const char* name;
+    const char* impl;
+    bool is_tf;
+
+    // the description was checked by smx_rts_topology_check_net()
+    name = smx_config_get_string( desc, "name", NULL );
+    impl = smx_config_get_string( desc, "impl", NULL );
+    smx_config_init_int( desc, "prio", &prio );
+    is_tf = ( strcmp( impl, "smx_tf" ) == 0 );
+    *net = smx_rts_net_create( rts, name, impl,
+            is_tf ? 0 : smx_rts_topology_count( desc, "in" ),
+            is_tf ? 0 : smx_rts_topology_count( desc, "out" ), prio );
+    if( *net == NULL )
+        return -1;
+
+    // a partially connected net is removed by the caller
+    if( is_tf )
+    {
+        rc = smx_rts_topology_connect_tf( *net, desc, chs );
+    }
+    else
+    {
+        rc = smx_rts_topology_connect( *net, desc, "in", chs,
+                smx_rts_connect_in );
+        if( rc == 0 )
+            rc = smx_rts_topology_connect( *net, desc, "out", chs,
+                    smx_rts_connect_out );
+    }
+    return rc;
+}
+
+/*****************************************************************************/
+static void smx_rts_topology_channel_destroy( smx_rts_t* rts,
+        smx_channel_t* ch )
+{
+    int i;
+
+    pthread_mutex_lock( &rts->net_mutex );
+    for( i = 0; i < rts->dyn_ch_cnt; i++ )
+    {
+        if( rts->dyn_chs[i] == ch )
+        {
+            rts->dyn_ch_cnt--;
+            memmove( &rts->dyn_chs[i], &rts->dyn_chs[i + 1],
+                    sizeof( smx_channel_t* ) * ( rts->dyn_ch_cnt - i ) );
+            break;
+        }
+    }
+    pthread_mutex_unlock( &rts->net_mutex );
+    smx_channel_destroy( ch );
+}
+
+/*****************************************************************************/
+static void smx_rts_topology_rollback( smx_rts_t* rts, smx_net_t** nets,
+        int net_cnt, smx_channel_t** chs, int ch_cnt )
+{
+    int i, j;
+    smx_net_t* expected;
+
+    // stop the nets which were already started
+    for( i = 0; i < net_cnt; i++ )
+    {
+        if( nets[i] == NULL || !nets[i]->has_thread )
+            continue;
+        pthread_mutex_lock( &rts->net_mutex );
+        smx_net_queue_update( nets[i], SMX_NET_UPDATE_STOP, NULL, false );
+        pthread_mutex_unlock( &rts->net_mutex );
+    }
+    // release started nets waiting for neighbours which never start
+    for( i = 0; i < net_cnt; i++ )
+    {
+        if( nets[i] != NULL && !nets[i]->has_thread )
+            smx_net_signal_ready( nets[i] );
+    }
+    for( i = 0; i < net_cnt; i++ )
+    {
+        if( nets[i] == NULL )
+            continue;
+        smx_rts_net_detach( nets[i] );
+        // temporal firewalls are not listed in the ports of the net
+        for( j = 0; j < ch_cnt; j++ )
+        {
+            if( chs[j] == NULL )
+                continue;
+            expected = nets[i];
+            __atomic_compare_exchange_n( &chs[j]->source->net, &expected,
+                    NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+            expected = nets[i];
+            __atomic_compare_exchange_n( &chs[j]->sink->net, &expected,
+                    NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+        }
+    }
+    for( i = 0; i < ch_cnt; i++ )
+    {
+        if( chs[i] != NULL )
+            smx_rts_topology_channel_destroy( rts, chs[i] );
+    }
+}
+
+/*****************************************************************************/
+int smx_program_load_topology( smx_rts_t* rts, const char* path )
+{
+    int i;
+    int net_cnt = 0;
+    int ch_cnt = 0;
+    int rc = -1;
+    bson_t doc;
+    bson_t desc;
+    bson_iter_t i_chs;
+    bson_iter_t i_nets;
+    bson_iter_t child;
+    void* handle = NULL;
+    smx_hmap_t* chs = NULL;
+    smx_channel_t** channels = NULL;
+    smx_net_t** nets = NULL;
+    void* ( **start_routines )( void* ) = NULL;
+
+    bson_init( &doc );
+    if( smx_program_init_bson_file( path, &doc ) < 0 )
+    {
+        bson_destroy( &doc );
+        return -1;
+    }
+
+    if( !bson_iter_init_find( &i_nets, &doc, "nets" )
+            || !BSON_ITER_HOLDS_ARRAY( &i_nets ) )
     {
-        SMX_LOG_MAIN( main, error, "barrier pre initialisation failed" );
+        SMX_LOG_MAIN( main, error, "missing mandatory key 'nets' in topology"
+                " '%s'", path );
+        bson_destroy( &doc );
+        return -1;
     }
-    if( pthread_barrier_init( &rts->init_done, NULL, rts->net_cnt ) != 0 )
+    if( bson_iter_init_find( &i_chs, &doc, "channels" )
+            && !BSON_ITER_HOLDS_ARRAY( &i_chs ) )
+    {
+        SMX_LOG_MAIN( main, error, "'channels' of topology '%s' must be an"
+                " array", path );
+        bson_destroy( &doc );
+        return -1;
+    }
+
+    handle = dlopen( NULL, RTLD_NOW );
+    chs = smx_hmap_create( 64 );
+    ch_cnt = smx_rts_topology_count( &doc, "channels" );
+    net_cnt = smx_rts_topology_count( &doc, "nets" );
+    channels = smx_malloc( sizeof( smx_channel_t* ) * SMX_MAX( ch_cnt, 1 ) );
+    nets = smx_malloc( sizeof( smx_net_t* ) * SMX_MAX( net_cnt, 1 ) );
+    start_routines = smx_malloc( sizeof( *start_routines )
+            * SMX_MAX( net_cnt, 1 ) );
+    if( handle == NULL || chs == NULL || channels == NULL || nets == NULL
+            || start_routines == NULL )
+        goto end;
+    memset( channels, 0, sizeof( smx_channel_t* ) * SMX_MAX( ch_cnt, 1 ) );
+    memset( nets, 0, sizeof( smx_net_t* ) * SMX_MAX( net_cnt, 1 ) );
+
+    // check the whole description before anything is created
+    if( ch_cnt > 0 && bson_iter_init_find( &i_chs, &doc, "channels" )
+            && bson_iter_recurse( &i_chs, &child ) )
+    {
+        for( i = 0; i < ch_cnt && bson_iter_next( &child ); i++ )
+        {
+            if( smx_rts_topology_init_doc( &child, &desc ) < 0
+                    || smx_rts_topology_check_channel( &desc, chs,
+                        &channels[i] ) < 0 )
+            {
+                SMX_LOG_MAIN( main, error, "bad channel description '%s' in"
+                        " '%s'", bson_iter_key( &child ), path );
+                goto end;
+            }
+        }
+    }
+    if( bson_iter_init_find( &i_nets, &doc, "nets" )
+            && bson_iter_recurse( &i_nets, &child ) )
+    {
+        for( i = 0; i < net_cnt && bson_iter_next( &child ); i++ )
+        {
+            if( smx_rts_topology_init_doc( &child, &desc ) < 0
+                    || smx_rts_topology_check_net( &desc, chs, handle,
+                        &start_routines[i] ) < 0 )
+            {
+                SMX_LOG_MAIN( main, error, "bad net description '%s' in"
+                        " '%s'", bson_iter_key( &child ), path );
+                goto end;
+            }
+        }
+    }
+
+    // create and connect the whole graph
+    if( ch_cnt > 0 && bson_iter_init_find( &i_chs, &doc, "channels" )
+            && bson_iter_recurse( &i_chs, &child ) )
+    {
+        for( i = 0; i < ch_cnt && bson_iter_next( &child ); i++ )
+        {
+            smx_rts_topology_init_doc( &child, &desc );
+            channels[i] = smx_rts_topology_load_channel( rts, &desc );
+            if( channels[i] == NULL )
+                goto rollback;
+        }
+    }
+    if( bson_iter_init_find( &i_nets, &doc, "nets" )
+            && bson_iter_recurse( &i_nets, &child ) )
+    {
+        for( i = 0; i < net_cnt && bson_iter_next( &child ); i++ )
+        {
+            smx_rts_topology_init_doc( &child, &desc );
+            if( smx_rts_topology_load_net( rts, &desc, chs, &nets[i] ) < 0 )
+            {
+                SMX_LOG_MAIN( main, error, "failed to connect net '%s' in"
+                        " '%s'", bson_iter_key( &child ), path );
+                goto rollback;
+            }
+        }
+    }
+
+    // start the nets only once the whole graph is connected
+    for( i = 0; i < net_cnt; i++ )
+    {
+        if( smx_rts_net_start( nets[i], start_routines[i] ) < 0 )
+            goto rollback;
+    }
+
+    SMX_LOG_MAIN( main, notice, "loaded topology '%s' with %d nets and %d"
+            " channels", path, net_cnt, ch_cnt );
+    rc = 0;
+    goto end;
+
+rollback:
+    SMX_LOG_MAIN( main, error, "failed to load topology '%s', removing the"
+            " nets and channels created so far", path );
+    smx_rts_topology_rollback( rts, nets, net_cnt, channels, ch_cnt );
+
+end:
+    if( start_routines != NULL )
+        free( start_routines );
+    if( nets != NULL )
+        free( nets );
+    if( channels != NULL )
+        free( channels );
+    if( chs != NULL )
+        smx_hmap_destroy( chs, NULL );
+    if( handle != NULL )
+        dlclose( handle );
+    bson_destroy( &doc );
+    return rc;
+}
+
+/*****************************************************************************/
+smx_channel_t* smx_rts_channel_create( smx_rts_t* rts, const char* name,
+        int len, smx_channel_type_t type )
+{
+    int id;
+    char cat_name[1000];
+    smx_channel_t* ch = NULL;
+
+    pthread_mutex_lock( &rts->net_mutex );
+    if( rts->dyn_ch_cnt == rts->dyn_ch_len )
+    {
+        if( smx_rts_resize( ( void** )&rts->dyn_chs, rts->dyn_ch_len,
+                    SMX_MAX( 16, rts->dyn_ch_len * 2 ),
+                    sizeof( smx_channel_t* ) ) < 0 )
+            goto end;
+        rts->dyn_ch_len = SMX_MAX( 16, rts->dyn_ch_len * 2 );
+    }
+    id = rts->ch_cnt;
+    snprintf( cat_name, sizeof( cat_name ), "ch_%s_%d", name, id );
+    ch = smx_channel_create( &rts->ch_cnt, len, type, id, name, cat_name );
+    if( ch != NULL )
+    {
+        rts->dyn_chs[rts->dyn_ch_cnt++] = ch;
+    }
+
+end:
+    pthread_mutex_unlock( &rts->net_mutex );
+    return ch;
+}
+
+/*****************************************************************************/
+int smx_rts_connect_in( smx_net_t* net, smx_channel_t* ch )
+{
+    int rc;
+    smx_net_t* expected = NULL;
+
+    if( net == NULL || ch == NULL )
+        return -1;
+
+    if( !__atomic_compare_exchange_n( &ch->source->net, &expected, net, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+    {
+        SMX_LOG_NET( net, error, "input of channel '%s' is already connected",
+                ch->name );
+        return -1;
+    }
+
+    // the collector of a routing node is attached by the node itself
+    pthread_mutex_lock( &net->rts->net_mutex );
+    rc = smx_net_queue_update( net, SMX_NET_UPDATE_ADD_IN, ch, false );
+    pthread_mutex_unlock( &net->rts->net_mutex );
+    if( rc < 0 )
+    {
+        __atomic_store_n( &ch->source->net, NULL, __ATOMIC_RELEASE );
+    }
+    return rc;
+}
+
+/*****************************************************************************/
+int smx_rts_connect_out( smx_net_t* net, smx_channel_t* ch )
+{
+    int rc;
+    smx_net_t* expected = NULL;
+
+    if( net == NULL || ch == NULL )
+        return -1;
+
+    if( !__atomic_compare_exchange_n( &ch->sink->net, &expected, net, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+    {
+        SMX_LOG_NET( net, error, "output of channel '%s' is already"
+                " connected", ch->name );
+        return -1;
+    }
+
+    pthread_mutex_lock( &net->rts->net_mutex );
+    rc = smx_net_queue_update( net, SMX_NET_UPDATE_ADD_OUT, ch, false );
+    pthread_mutex_unlock( &net->rts->net_mutex );
+    if( rc < 0 )
+    {
+        __atomic_store_n( &ch->sink->net, NULL, __ATOMIC_RELEASE );
+    }
+    return rc;
+}
+
+/*****************************************************************************/
+smx_net_t* smx_rts_net_create( smx_rts_t* rts, const char* name,
+        const char* impl, int indegree, int outdegree, int prio )
+{
+    int id;
+    char cat_name[1000];
+    smx_net_t* net;
+
+    pthread_mutex_lock( &rts->net_mutex );
+    id = rts->net_cnt;
+    snprintf( cat_name, sizeof( cat_name ), "net_%s_%d", name, id );
+    net = smx_net_create( id, name, impl, cat_name, rts, prio );
+    if( net != NULL )
+    {
+        smx_net_init( net, indegree, outdegree );
+        if( strcmp( impl, "smx_rn" ) == 0 )
+            smx_net_init_rn( net );
+        net->next = rts->dyn_nets;
+        rts->dyn_nets = net;
+    }
+    pthread_mutex_unlock( &rts->net_mutex );
+    return net;
+}
+
+/*****************************************************************************/
+static void smx_rts_net_destroy( smx_net_t* net )
+{
+    if( net->impl != NULL && strcmp( net->impl, "smx_rn" ) == 0 )
+        smx_net_destroy_rn( net );
+    else if( net->impl != NULL && strcmp( net->impl, "smx_tf" ) == 0
+            && net->attr != NULL )
+        smx_net_destroy_tf( net );
+    smx_net_destroy( net );
+}
+
+/*****************************************************************************/
+int smx_rts_net_detach( smx_net_t* net )
+{
+    int i;
+    smx_net_t** item;
+    smx_channel_t* ch;
+    smx_net_t* peer;
+    smx_net_t* expected;
+    smx_rts_t* rts;
+
+    if( net == NULL )
+        return -1;
+
+    rts = net->rts;
+    if( net->has_thread )
+    {
+        pthread_join( net->thread, NULL );
+    }
+
+    pthread_mutex_lock( &rts->net_mutex );
+    for( item = &rts->dyn_nets; *item != NULL; item = &( *item )->next )
+    {
+        if( *item == net )
+            break;
+    }
+    if( *item == NULL )
+    {
+        pthread_mutex_unlock( &rts->net_mutex );
+        SMX_LOG_NET( net, error, "only nets created at runtime can be"
+                " detached" );
+        return -1;
+    }
+    *item = net->next;
+
+    for( i = 0; i < net->sig->out.count; i++ )
+    {
+        ch = net->sig->out.ports[i];
+        if( ch == NULL )
+            continue;
+        peer = ch->source->net;
+        if( peer != NULL && peer != net )
+            smx_net_queue_update( peer, SMX_NET_UPDATE_REMOVE_IN, ch, false );
+        expected = net;
+        __atomic_compare_exchange_n( &ch->sink->net, &expected, NULL, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+    }
+    for( i = 0; i < net->sig->in.count; i++ )
+    {
+        ch = net->sig->in.ports[i];
+        if( ch == NULL )
+            continue;
+        expected = net;
+        __atomic_compare_exchange_n( &ch->source->net, &expected, NULL, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+    }
+    pthread_mutex_unlock( &rts->net_mutex );
+
+    SMX_LOG_MAIN( main, notice, "detached net %s(%d)", net->name, net->id );
+    smx_rts_net_destroy( net );
+    return 0;
+}
+
+/*****************************************************************************/
+int smx_rts_net_drain( smx_net_t* net )
+{
+    int i;
+    int rc = 0;
+    int in_cnt = 0;
+    smx_channel_t* ch;
+    smx_net_t* peer;
+
+    if( net == NULL )
+        return -1;
+
+    pthread_mutex_lock( &net->rts->net_mutex );
+    for( i = 0; i < net->sig->in.count; i++ )
+    {
+        ch = net->sig->in.ports[i];
+        if( ch == NULL )
+            continue;
+        in_cnt++;
+        peer = ch->sink->net;
+        if( peer != NULL && peer != net && peer->is_running )
+        {
+            // the producer stops writing and terminates the channel
+            rc |= smx_net_queue_update( peer, SMX_NET_UPDATE_REMOVE_OUT, ch,
+                    true );
+        }
+        else
+        {
+            smx_channel_terminate_source( ch );
+            smx_collector_terminate( ch );
+        }
+    }
+    if( in_cnt == 0 )
+    {
+        rc |= smx_net_queue_update( net, SMX_NET_UPDATE_STOP, NULL, false );
+    }
+    pthread_mutex_unlock( &net->rts->net_mutex );
+
+    SMX_LOG_NET( net, notice, "draining net" );
+    return ( rc < 0 ) ? -1 : 0;
+}
+
+/*****************************************************************************/
+int smx_rts_net_start( smx_net_t* net, void* start_routine( void* ) )
+{
+    int rc;
+
+    if( net == NULL || start_routine == NULL )
+        return -1;
+
+    pthread_mutex_lock( &net->rts->net_mutex );
+    rc = smx_net_run( &net->thread, 0, start_routine, net );
+    pthread_mutex_unlock( &net->rts->net_mutex );
+    return rc;
+}
+
+/*****************************************************************************/
+int smx_rts_set_channel( smx_rts_t* rts, int id, smx_channel_t* ch )
+{
+    int len;
+
+    if( ch == NULL || id < 0 )
+    {
+        SMX_LOG_MAIN( main, fatal, "failed to create channel %d", id );
+        return -1;
+    }
+
+    if( id >= rts->ch_len )
+    {
+        len = SMX_MAX( id + 1, rts->ch_len * 2 );
+        if( smx_rts_resize( ( void** )&rts->chs, rts->ch_len, len,
+                    sizeof( smx_channel_t* ) ) < 0 )
+        {
+            SMX_LOG_MAIN( main, fatal, "failed to grow the channel table to"
+                    " %d entries", len );
+            return -1;
+        }
+        rts->ch_len = len;
+    }
+    rts->chs[id] = ch;
+    return 0;
+}
+
+/*****************************************************************************/
+int smx_rts_set_net( smx_rts_t* rts, int id, smx_net_t* net )
+{
+    if( net == NULL || id < 0 )
+    {
+        SMX_LOG_MAIN( main, fatal, "failed to create net %d", id );
+        return -1;
+    }
+
+    if( id >= rts->net_len && smx_rts_resize_nets( rts,
+                SMX_MAX( id + 1, rts->net_len * 2 ) ) < 0 )
+    {
+        SMX_LOG_MAIN( main, fatal, "failed to grow the net table to %d"
+                " entries", SMX_MAX( id + 1, rts->net_len * 2 ) );
+        return -1;
+    }
+    rts->nets[id] = net;
+    return 0;
+}
+
+/*****************************************************************************/
+void smx_rts_topology_cleanup( smx_rts_t* rts )
+{
+    int i;
+    smx_net_t* net;
+
+    while( rts->dyn_nets != NULL )
+    {
+        net = rts->dyn_nets;
+        rts->dyn_nets = net->next;
+        if( net->has_thread )
+        {
+            pthread_join( net->thread, NULL );
+        }
+        smx_rts_net_destroy( net );
+    }
+    for( i = 0; i < rts->dyn_ch_cnt; i++ )
+    {
+        smx_channel_destroy( rts->dyn_chs[i] );
+    }
+    free( rts->dyn_chs );
+    rts->dyn_chs = NULL;
+    rts->dyn_ch_cnt = 0;
+}
+
+/*****************************************************************************/
+static smx_rts_shared_state_t* smx_rts_shared_state_find(
+        smx_rts_shared_state_table_t* table, const char* key, uint64_t hash )
+{
+    smx_rts_shared_state_node_t* node;
+
+    node = rcu_dereference( table->buckets[hash & ( table->size - 1 )] );
+    while( node != NULL )
+    {
+        if( node->hash == hash && strcmp( node->item->key, key ) == 0 )
+            return node->item;
+        node = rcu_dereference( node->next );
+    }
+    return NULL;
+}
+
+/*****************************************************************************/
+static smx_rts_shared_state_table_t* smx_rts_shared_state_table_create(
+        unsigned int size )
+{
+    smx_rts_shared_state_table_t* table;
+
+    table = smx_malloc( sizeof( struct smx_rts_shared_state_table_s ) );
+    if( table == NULL )
+        return NULL;
+
+    table->buckets = calloc( size, sizeof( smx_rts_shared_state_node_t* ) );
+    if( table->buckets == NULL )
+    {
+        free( table );
+        return NULL;
+    }
+    table->size = size;
+    return table;
+}
+
+/*****************************************************************************/
+static void smx_rts_shared_state_table_destroy(
+        smx_rts_shared_state_table_t* table, bool free_items )
+{
+    unsigned int i;
+    smx_rts_shared_state_node_t* node;
+    smx_rts_shared_state_node_t* next;
+
+    for( i = 0; i < table->size; i++ )
+    {
+        node = table->buckets[i];
+        while( node != NULL )
+        {
+            next = node->next;
+            if( free_items )
+            {
+                if( node->item->cleanup != NULL )
+                    node->item->cleanup( node->item->state );
+                free( node->item->key );
+                free( node->item );
+            }
+            free( node );
+            node = next;
+        }
+    }
+    free( table->buckets );
+    free( table );
+}
+
+/*****************************************************************************/
+static int smx_rts_shared_state_table_add( smx_rts_shared_state_table_t* table,
+        smx_rts_shared_state_t* item, uint64_t hash )
+{
+    smx_rts_shared_state_node_t** bucket;
+    smx_rts_shared_state_node_t* node;
+
+    node = smx_malloc( sizeof( struct smx_rts_shared_state_node_s ) );
+    if( node == NULL )
+        return -1;
+
+    bucket = &table->buckets[hash & ( table->size - 1 )];
+    node->item = item;
+    node->hash = hash;
+    node->next = *bucket;
+    rcu_assign_pointer( *bucket, node );
+    return 0;
+}
+
+/*****************************************************************************/
+static void smx_rts_shared_state_retire( smx_rts_shared_state_table_t* table )
+{
+    if( table == NULL )
+        return;
+
+    // must not be called with the registry mutex held
+    synchronize_rcu();
+    smx_rts_shared_state_table_destroy( table, false );
+}
+
+/*****************************************************************************/
+static int smx_rts_shared_state_grow( smx_rts_shared_state_registry_t* reg,
+        smx_rts_shared_state_table_t** retired )
+{
+    unsigned int i;
+    smx_rts_shared_state_node_t* node;
+    smx_rts_shared_state_table_t* old = reg->table;
+    smx_rts_shared_state_table_t* table;
+
+    table = smx_rts_shared_state_table_create( old->size * 2 );
+    if( table == NULL )
+        return -1;
+
+    for( i = 0; i < old->size; i++ )
+    {
+        for( node = old->buckets[i]; node != NULL; node = node->next )
+        {
+            if( smx_rts_shared_state_table_add( table, node->item,
+                        node->hash ) < 0 )
+            {
+                smx_rts_shared_state_table_destroy( table, false );
+                return -1;
+            }
+        }
+    }
+
+    // the old table is freed by the caller once the mutex is released
+    rcu_assign_pointer( reg->table, table );
+    *retired = old;
+    return 0;
+}
+
+/*****************************************************************************/
+static int smx_rts_shared_state_insert( smx_rts_shared_state_registry_t* reg,
+        const char* key, uint64_t hash, void* state, void cleanup( void* ),
+        smx_rts_shared_state_table_t** retired )
+{
+    smx_rts_shared_state_t* item;
+
+    item = smx_malloc( sizeof( struct smx_rts_shared_state_s ) );
+    if( item == NULL )
+        return -1;
+
+    item->key = strdup( key );
+    item->state = state;
+    item->cleanup = cleanup;
+    if( smx_rts_shared_state_table_add( reg->table, item, hash ) < 0 )
+    {
+        free( item->key );
+        free( item );
+        return -1;
+    }
+
+    reg->count++;
+    if( reg->count > reg->table->size - reg->table->size / 4 )
+        smx_rts_shared_state_grow( reg, retired );
+
+    return 0;
+}
+
+/*****************************************************************************/
+smx_rts_shared_state_registry_t* smx_rts_shared_state_create()
+{
+    smx_rts_shared_state_registry_t* reg;
+
+    reg = smx_malloc( sizeof( struct smx_rts_shared_state_registry_s ) );
+    if( reg == NULL )
+        return NULL;
+
+    reg->table = smx_rts_shared_state_table_create( 16 );
+    if( reg->table == NULL )
+    {
+        free( reg );
+        return NULL;
+    }
+    reg->count = 0;
+    pthread_mutex_init( &reg->mutex, NULL );
+    return reg;
+}
+
+/*****************************************************************************/
+void smx_rts_shared_state_destroy( smx_rts_shared_state_registry_t* reg )
+{
+    if( reg == NULL )
+        return;
+
+    smx_rts_shared_state_table_destroy( reg->table, true );
+    pthread_mutex_destroy( &reg->mutex );
+    free( reg );
+}
+
+/*****************************************************************************/
+void* smx_rts_shared_state_get( smx_rts_t* rts, const char* key )
+{
+    smx_rts_shared_state_t* item;
+
+    if( rts == NULL || key == NULL )
+        return NULL;
+
+    rcu_read_lock();
+    item = smx_rts_shared_state_find( rcu_dereference( rts->shared_state->table ),
+            key, smx_hmap_hash( key, strlen( key ) ) );
+    rcu_read_unlock();
+
+    return ( item == NULL ) ? NULL : item->state;
+}
+
+/*****************************************************************************/
+int smx_rts_shared_state_get_or_init( smx_rts_t* rts, const char* key,
+        void* h, int init( void*, void** ), void cleanup( void* ),
+        void** state )
+{
+    int rc;
+    uint64_t hash = smx_hmap_hash( key, strlen( key ) );
+    smx_rts_shared_state_t* item;
+    smx_rts_shared_state_table_t* retired = NULL;
+    smx_rts_shared_state_registry_t* reg = rts->shared_state;
+
+    rcu_read_lock();
+    item = smx_rts_shared_state_find( rcu_dereference( reg->table ), key,
+            hash );
+    rcu_read_unlock();
+    if( item != NULL )
+    {
+        *state = item->state;
+        return 1;
+    }
+
+    // initialise without the mutex such that a slow init does not block
+    // unrelated lookups and insertions
+    *state = NULL;
+    rc = init( h, state );
+    if( rc < 0 )
+    {
+        // release whatever the init allocated before it failed
+        cleanup( *state );
+        *state = NULL;
+        return -1;
+    }
+
+    // only insert if no other net registered the key in the meantime
+    pthread_mutex_lock( &reg->mutex );
+    item = smx_rts_shared_state_find( reg->table, key, hash );
+    if( item == NULL )
+    {
+        rc = smx_rts_shared_state_insert( reg, key, hash, *state, cleanup,
+                &retired );
+    }
+    pthread_mutex_unlock( &reg->mutex );
+    smx_rts_shared_state_retire( retired );
+
+    if( item != NULL )
+    {
+        // the item of the other net wins, drop our own
+        cleanup( *state );
+        *state = item->state;
+        return 1;
+    }
+    if( rc < 0 )
+    {
+        cleanup( *state );
+        *state = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+int smx_rts_shared_state_put( smx_rts_t* rts, const char* key, void* state,
+        void cleanup( void* ) )
+{
+    int rc = -1;
+    uint64_t hash;
+    smx_rts_shared_state_table_t* retired = NULL;
+    smx_rts_shared_state_registry_t* reg;
+
+    if( rts == NULL || key == NULL )
+        return -1;
+
+    reg = rts->shared_state;
+    hash = smx_hmap_hash( key, strlen( key ) );
+    pthread_mutex_lock( &reg->mutex );
+    if( smx_rts_shared_state_find( reg->table, key, hash ) == NULL )
+        rc = smx_rts_shared_state_insert( reg, key, hash, state, cleanup,
+                &retired );
+    pthread_mutex_unlock( &reg->mutex );
+    smx_rts_shared_state_retire( retired );
+
+    if( rc < 0 )
     {
-        SMX_LOG_MAIN( main, error, "barrier initialisation failed" );
+        SMX_LOG_MAIN( main, error, "failed to add shared state with key '%s'",
+                key );
     }
+    return rc;
 }
 
 /******************************************************************************/
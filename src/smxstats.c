@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @author  Simon Maurer
+ *
+ * Latency statistics for the runtime system library of Streamix
+ */
+
+#include <string.h>
+#include "smxlog.h"
+#include "smxstats.h"
+#include "smxutils.h"
+
+/*****************************************************************************/
+static int smx_hist_get_idx( uint64_t val )
+{
+    int msb;
+
+    if( val < SMX_HIST_SUB_COUNT )
+        return val;
+
+    msb = 63 - __builtin_clzll( val );
+    if( msb >= SMX_HIST_MAX_BITS )
+        return SMX_HIST_BUCKET_COUNT - 1;
+
+    return ( msb - SMX_HIST_SUB_BITS + 1 ) * SMX_HIST_SUB_COUNT
+        + ( int )( val >> ( msb - SMX_HIST_SUB_BITS ) ) - SMX_HIST_SUB_COUNT;
+}
+
+/*****************************************************************************/
+static uint64_t smx_hist_get_upper_bound( int idx )
+{
+    int shift;
+    uint64_t sub;
+
+    if( idx < SMX_HIST_SUB_COUNT )
+        return idx;
+
+    shift = idx / SMX_HIST_SUB_COUNT - 1;
+    sub = idx % SMX_HIST_SUB_COUNT + SMX_HIST_SUB_COUNT;
+    return ( ( sub + 1 ) << shift ) - 1;
+}
+
+/*****************************************************************************/
+uint64_t smx_hist_get_percentile( smx_hist_t* hist, double percentile )
+{
+    int i;
+    uint64_t rank;
+    uint64_t cnt = 0;
+
+    if( hist->count == 0 )
+        return 0;
+
+    rank = ( uint64_t )( percentile / 100.0 * hist->count + 0.5 );
+    if( rank == 0 )
+        rank = 1;
+
+    for( i = 0; i < SMX_HIST_BUCKET_COUNT; i++ )
+    {
+        cnt += hist->buckets[i];
+        if( cnt >= rank )
+        {
+            if( i == SMX_HIST_BUCKET_COUNT - 1 )
+                return hist->max;
+            return SMX_MAX( hist->min,
+                    SMX_MIN( smx_hist_get_upper_bound( i ), hist->max ) );
+        }
+    }
+
+    return hist->max;
+}
+
+/*****************************************************************************/
+double smx_hist_get_mean( smx_hist_t* hist )
+{
+    if( hist->count == 0 )
+        return 0;
+
+    return ( double )hist->sum / hist->count;
+}
+
+/*****************************************************************************/
+void smx_hist_init( smx_hist_t* hist )
+{
+    memset( hist, 0, sizeof( struct smx_hist_s ) );
+    hist->min = UINT64_MAX;
+}
+
+/*****************************************************************************/
+void smx_hist_log( zlog_category_t* cat, const char* name, smx_hist_t* hist )
+{
+    if( hist->count == 0 )
+    {
+        SMX_LOG_INTERN( notice, cat, "%s: no samples", name );
+        return;
+    }
+
+    SMX_LOG_INTERN( notice, cat, "%s [us]: count: %lu, min: %.3f, mean: %.3f,"
+            " p50: %.3f, p90: %.3f, p99: %.3f, p99.9: %.3f, max: %.3f", name,
+            hist->count, hist->min / 1000.0, smx_hist_get_mean( hist ) / 1000.0,
+            smx_hist_get_percentile( hist, 50 ) / 1000.0,
+            smx_hist_get_percentile( hist, 90 ) / 1000.0,
+            smx_hist_get_percentile( hist, 99 ) / 1000.0,
+            smx_hist_get_percentile( hist, 99.9 ) / 1000.0,
+            hist->max / 1000.0 );
+}
+
+/*****************************************************************************/
+void smx_hist_record( smx_hist_t* hist, uint64_t val )
+{
+    hist->buckets[smx_hist_get_idx( val )]++;
+    hist->count++;
+    hist->sum += val;
+    if( val < hist->min )
+        hist->min = val;
+    if( val > hist->max )
+        hist->max = val;
+}
@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @author  Simon Maurer
+ *
+ * Synchronisation primitives for shared state of the runtime system library
+ * of Streamix.
+ */
+
+#include <string.h>
+#include <urcu.h>
+#include "smxlog.h"
+#include "smxstats.h"
+#include "smxsync.h"
+#include "smxutils.h"
+
+/*****************************************************************************/
+smx_rcu_ptr_t* smx_rcu_ptr_create( void* h, const char* name, void* ptr,
+        void cleanup( void* ) )
+{
+    smx_net_t* net = h;
+    smx_rcu_ptr_t* rcu_ptr;
+
+    if( net == NULL || name == NULL )
+        return NULL;
+
+    rcu_ptr = smx_malloc( sizeof( struct smx_rcu_ptr_s ) );
+    if( rcu_ptr == NULL )
+        return NULL;
+
+    rcu_ptr->ptr = ptr;
+    rcu_ptr->cleanup = cleanup;
+    rcu_ptr->name = strdup( name );
+    rcu_ptr->writes = 0;
+    rcu_ptr->write_contended = 0;
+    smx_hist_init( &rcu_ptr->grace );
+    pthread_mutex_init( &rcu_ptr->mutex, NULL );
+
+    pthread_mutex_lock( &net->rts->net_mutex );
+    rcu_ptr->next = net->rts->rcu_ptrs;
+    net->rts->rcu_ptrs = rcu_ptr;
+    pthread_mutex_unlock( &net->rts->net_mutex );
+
+    SMX_LOG_NET( net, info, "created RCU pointer '%s'", name );
+    return rcu_ptr;
+}
+
+/*****************************************************************************/
+void smx_rcu_ptr_publish( smx_rcu_ptr_t* rcu_ptr, void* ptr )
+{
+    void* old;
+    uint64_t start;
+
+    if( pthread_mutex_trylock( &rcu_ptr->mutex ) != 0 )
+    {
+        pthread_mutex_lock( &rcu_ptr->mutex );
+        rcu_ptr->write_contended++;
+    }
+
+    old = rcu_xchg_pointer( &rcu_ptr->ptr, ptr );
+    start = smx_time_get_ns();
+    synchronize_rcu();
+    smx_hist_record( &rcu_ptr->grace, smx_time_get_ns() - start );
+    rcu_ptr->writes++;
+    pthread_mutex_unlock( &rcu_ptr->mutex );
+
+    if( old != NULL && old != ptr && rcu_ptr->cleanup != NULL )
+        rcu_ptr->cleanup( old );
+}
+
+/*****************************************************************************/
+void* smx_rcu_ptr_read_lock( smx_rcu_ptr_t* rcu_ptr )
+{
+    rcu_read_lock();
+    return rcu_dereference( rcu_ptr->ptr );
+}
+
+/*****************************************************************************/
+void smx_rcu_ptr_read_unlock( smx_rcu_ptr_t* rcu_ptr )
+{
+    ( void )rcu_ptr;
+    rcu_read_unlock();
+}
+
+/*****************************************************************************/
+smx_seqlock_t* smx_seqlock_create( void* h, const char* name, size_t size,
+        const void* init )
+{
+    smx_net_t* net = h;
+    smx_seqlock_t* lock;
+
+    if( net == NULL || name == NULL || size == 0 )
+        return NULL;
+
+    lock = smx_malloc( sizeof( struct smx_seqlock_s ) );
+    if( lock == NULL )
+        return NULL;
+
+    lock->data = smx_malloc( size );
+    if( lock->data == NULL )
+    {
+        free( lock );
+        return NULL;
+    }
+    if( init == NULL )
+        memset( lock->data, 0, size );
+    else
+        memcpy( lock->data, init, size );
+
+    lock->seq = 0;
+    lock->size = size;
+    lock->name = strdup( name );
+    lock->writes = 0;
+    lock->read_retries = 0;
+    lock->write_contended = 0;
+    pthread_mutex_init( &lock->mutex, NULL );
+
+    pthread_mutex_lock( &net->rts->net_mutex );
+    lock->next = net->rts->seqlocks;
+    net->rts->seqlocks = lock;
+    pthread_mutex_unlock( &net->rts->net_mutex );
+
+    SMX_LOG_NET( net, info, "created seqlock '%s' of %zu bytes", name, size );
+    return lock;
+}
+
+/*****************************************************************************/
+void smx_seqlock_read( smx_seqlock_t* lock, void* dst )
+{
+    unsigned int seq;
+    unsigned long retries = 0;
+
+    while( true )
+    {
+        seq = __atomic_load_n( &lock->seq, __ATOMIC_ACQUIRE );
+        if( ( seq & 1 ) == 0 )
+        {
+            memcpy( dst, lock->data, lock->size );
+            __atomic_thread_fence( __ATOMIC_ACQUIRE );
+            if( __atomic_load_n( &lock->seq, __ATOMIC_RELAXED ) == seq )
+                break;
+        }
+        retries++;
+    }
+
+    if( retries > 0 )
+        __atomic_fetch_add( &lock->read_retries, retries, __ATOMIC_RELAXED );
+}
+
+/*****************************************************************************/
+void smx_seqlock_write( smx_seqlock_t* lock, const void* src )
+{
+    if( pthread_mutex_trylock( &lock->mutex ) != 0 )
+    {
+        pthread_mutex_lock( &lock->mutex );
+        lock->write_contended++;
+    }
+
+    __atomic_store_n( &lock->seq, lock->seq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    memcpy( lock->data, src, lock->size );
+    __atomic_store_n( &lock->seq, lock->seq + 1, __ATOMIC_RELEASE );
+    lock->writes++;
+
+    pthread_mutex_unlock( &lock->mutex );
+}
+
+/*****************************************************************************/
+void smx_sync_cleanup( smx_rts_t* rts )
+{
+    smx_seqlock_t* lock;
+    smx_rcu_ptr_t* rcu_ptr;
+    char name[1000];
+
+    while( rts->seqlocks != NULL )
+    {
+        lock = rts->seqlocks;
+        rts->seqlocks = lock->next;
+        SMX_LOG_MAIN( main, notice, "seqlock '%s': %lu writes (%lu contended),"
+                " %lu read retries", lock->name, lock->writes,
+                lock->write_contended, lock->read_retries );
+        pthread_mutex_destroy( &lock->mutex );
+        free( lock->name );
+        free( lock->data );
+        free( lock );
+    }
+
+    while( rts->rcu_ptrs != NULL )
+    {
+        rcu_ptr = rts->rcu_ptrs;
+        rts->rcu_ptrs = rcu_ptr->next;
+        SMX_LOG_MAIN( main, notice, "RCU pointer '%s': %lu updates (%lu"
+                " contended)", rcu_ptr->name, rcu_ptr->writes,
+                rcu_ptr->write_contended );
+        if( rcu_ptr->grace.count > 0 )
+        {
+            snprintf( name, sizeof( name ), "RCU pointer '%s' grace period",
+                    rcu_ptr->name );
+            smx_hist_log( smx_get_zcat_main(), name, &rcu_ptr->grace );
+        }
+        if( rcu_ptr->ptr != NULL && rcu_ptr->cleanup != NULL )
+            rcu_ptr->cleanup( rcu_ptr->ptr );
+        pthread_mutex_destroy( &rcu_ptr->mutex );
+        free( rcu_ptr->name );
+        free( rcu_ptr );
+    }
+}
@@ -0,0 +1,361 @@
+/* SPDX-License-Identifier: MPL-2.0 */
+/**
+ * @author  Simon Maurer
+ *
+ * A hierarchical timer wheel for the runtime system library of Streamix
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include "smxlog.h"
+#include "smxstats.h"
+#include "smxtimer.h"
+#include "smxutils.h"
+
+#define SMX_TIMER_WHEEL_SLOT_MASK ( SMX_TIMER_WHEEL_SLOTS - 1 )
+
+static smx_timer_wheel_t* smx_timer_wheel = NULL;
+static pthread_mutex_t smx_timer_wheel_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*****************************************************************************/
+static void smx_timer_link( smx_timer_wheel_t* wheel, smx_timer_entry_t* timer,
+        uint64_t min_expiry )
+{
+    int level;
+    uint64_t delta;
+    uint64_t range;
+    smx_timer_entry_t** slot;
+
+    timer->expiry = ( timer->deadline + SMX_TIMER_WHEEL_TICK_NS - 1 )
+        / SMX_TIMER_WHEEL_TICK_NS;
+    if( timer->expiry < min_expiry )
+        timer->expiry = min_expiry;
+
+    delta = timer->expiry - wheel->tick;
+    range = 1ULL << ( SMX_TIMER_WHEEL_LEVELS * SMX_TIMER_WHEEL_SLOT_BITS );
+    if( delta >= range )
+    {
+        // out of range, the timer is re-linked once the clamped expiry passed
+        timer->expiry = wheel->tick + range - 1;
+        delta = range - 1;
+    }
+    for( level = 0; level < SMX_TIMER_WHEEL_LEVELS - 1; level++ )
+    {
+        if( delta < ( 1ULL << ( ( level + 1 ) * SMX_TIMER_WHEEL_SLOT_BITS ) ) )
+            break;
+    }
+
+    slot = &wheel->slots[level][( timer->expiry
+            >> ( level * SMX_TIMER_WHEEL_SLOT_BITS ) )
+            & SMX_TIMER_WHEEL_SLOT_MASK];
+    timer->slot = slot;
+    timer->prev = NULL;
+    timer->next = *slot;
+    if( *slot != NULL )
+        ( *slot )->prev = timer;
+    *slot = timer;
+}
+
+/*****************************************************************************/
+static void smx_timer_unlink( smx_timer_entry_t* timer )
+{
+    if( timer->prev != NULL )
+        timer->prev->next = timer->next;
+    else
+        *timer->slot = timer->next;
+    if( timer->next != NULL )
+        timer->next->prev = timer->prev;
+    timer->prev = NULL;
+    timer->next = NULL;
+    timer->slot = NULL;
+}
+
+/*****************************************************************************/
+static void smx_timer_fire( smx_timer_wheel_t* wheel, smx_timer_entry_t* timer,
+        uint64_t now )
+{
+    if( ( timer->deadline + SMX_TIMER_WHEEL_TICK_NS - 1 )
+            / SMX_TIMER_WHEEL_TICK_NS > wheel->tick )
+    {
+        // the expiry was clamped to the range of the wheel
+        smx_timer_link( wheel, timer, wheel->tick + 1 );
+        return;
+    }
+
+    smx_hist_record( &wheel->jitter,
+            ( now > timer->deadline ) ? now - timer->deadline : 0 );
+    wheel->fired++;
+    if( timer->period > 0 )
+    {
+        timer->deadline += timer->period;
+        while( timer->deadline <= now )
+        {
+            timer->deadline += timer->period;
+            timer->missed++;
+        }
+        smx_timer_link( wheel, timer, wheel->tick + 1 );
+    }
+    else
+    {
+        timer->is_armed = false;
+        wheel->count--;
+    }
+    timer->callback( timer->arg );
+}
+
+/*****************************************************************************/
+static void smx_timer_advance( smx_timer_wheel_t* wheel, uint64_t now )
+{
+    int level;
+    unsigned int idx;
+    smx_timer_entry_t* timer;
+    smx_timer_entry_t** slot;
+
+    wheel->tick++;
+
+    // cascade the higher levels from top to bottom once their slot is due
+    for( level = SMX_TIMER_WHEEL_LEVELS - 1; level > 0; level-- )
+    {
+        if( ( wheel->tick & ( ( 1ULL << ( level * SMX_TIMER_WHEEL_SLOT_BITS ) )
+                        - 1 ) ) != 0 )
+            continue;
+        idx = ( wheel->tick >> ( level * SMX_TIMER_WHEEL_SLOT_BITS ) )
+            & SMX_TIMER_WHEEL_SLOT_MASK;
+        slot = &wheel->slots[level][idx];
+        while( ( timer = *slot ) != NULL )
+        {
+            smx_timer_unlink( timer );
+            smx_timer_link( wheel, timer, wheel->tick );
+        }
+    }
+
+    slot = &wheel->slots[0][wheel->tick & SMX_TIMER_WHEEL_SLOT_MASK];
+    while( ( timer = *slot ) != NULL )
+    {
+        smx_timer_unlink( timer );
+        smx_timer_fire( wheel, timer, now );
+    }
+}
+
+/*****************************************************************************/
+static uint64_t smx_timer_next_tick( smx_timer_wheel_t* wheel )
+{
+    int level;
+    int shift;
+    uint64_t j;
+    uint64_t base;
+    uint64_t next = UINT64_MAX;
+
+    // the first non-empty slot of each level, higher levels cascade at the
+    // start of their slot
+    for( level = 0; level < SMX_TIMER_WHEEL_LEVELS; level++ )
+    {
+        shift = level * SMX_TIMER_WHEEL_SLOT_BITS;
+        base = wheel->tick >> shift;
+        for( j = 1; j <= SMX_TIMER_WHEEL_SLOTS; j++ )
+        {
+            if( wheel->slots[level][( base + j ) & SMX_TIMER_WHEEL_SLOT_MASK]
+                    != NULL )
+            {
+                if( ( ( base + j ) << shift ) < next )
+                    next = ( base + j ) << shift;
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+/*****************************************************************************/
+static void* smx_timer_run( void* arg )
+{
+    uint64_t now;
+    uint64_t now_tick;
+    uint64_t next_tick;
+    struct timespec next;
+    smx_timer_wheel_t* wheel = arg;
+
+    SMX_LOG_MAIN( main, notice, "start timer thread (tick: %d ns)",
+            SMX_TIMER_WHEEL_TICK_NS );
+    pthread_mutex_lock( &wheel->mutex );
+    while( wheel->is_running )
+    {
+        if( wheel->count == 0 )
+        {
+            pthread_cond_wait( &wheel->cv, &wheel->mutex );
+            continue;
+        }
+
+        // sleep until the next event, arming an earlier timer signals the cv
+        wheel->next_tick = smx_timer_next_tick( wheel );
+        smx_time_ns_to_timespec( wheel->next_tick * SMX_TIMER_WHEEL_TICK_NS,
+                &next );
+        pthread_cond_timedwait( &wheel->cv, &wheel->mutex, &next );
+        wheel->next_tick = UINT64_MAX;
+
+        now = smx_time_get_ns();
+        now_tick = now / SMX_TIMER_WHEEL_TICK_NS;
+        while( wheel->tick < now_tick )
+        {
+            // skip the ticks without an expiry or a cascade
+            next_tick = smx_timer_next_tick( wheel );
+            if( next_tick > now_tick )
+            {
+                wheel->tick = now_tick;
+                break;
+            }
+            wheel->tick = next_tick - 1;
+            smx_timer_advance( wheel, now );
+        }
+    }
+    pthread_mutex_unlock( &wheel->mutex );
+    SMX_LOG_MAIN( main, notice, "terminate timer thread" );
+    return NULL;
+}
+
+/*****************************************************************************/
+static smx_timer_wheel_t* smx_timer_wheel_get()
+{
+    pthread_condattr_t attr;
+    smx_timer_wheel_t* wheel;
+
+    pthread_mutex_lock( &smx_timer_wheel_mutex );
+    if( smx_timer_wheel != NULL )
+    {
+        wheel = smx_timer_wheel;
+        goto end;
+    }
+
+    wheel = smx_malloc( sizeof( struct smx_timer_wheel_s ) );
+    if( wheel == NULL )
+        goto end;
+
+    memset( wheel->slots, 0, sizeof( wheel->slots ) );
+    wheel->tick = smx_time_get_ns() / SMX_TIMER_WHEEL_TICK_NS;
+    wheel->next_tick = UINT64_MAX;
+    wheel->count = 0;
+    wheel->fired = 0;
+    wheel->is_running = true;
+    smx_hist_init( &wheel->jitter );
+    pthread_mutex_init( &wheel->mutex, NULL );
+    pthread_condattr_init( &attr );
+    pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+    pthread_cond_init( &wheel->cv, &attr );
+    pthread_condattr_destroy( &attr );
+    if( pthread_create( &wheel->thread, NULL, smx_timer_run, wheel ) != 0 )
+    {
+        SMX_LOG_MAIN( main, error, "failed to start timer thread" );
+        pthread_mutex_destroy( &wheel->mutex );
+        pthread_cond_destroy( &wheel->cv );
+        free( wheel );
+        wheel = NULL;
+        goto end;
+    }
+    smx_timer_wheel = wheel;
+
+end:
+    pthread_mutex_unlock( &smx_timer_wheel_mutex );
+    return wheel;
+}
+
+/*****************************************************************************/
+int smx_timer_arm( smx_timer_entry_t* timer, uint64_t deadline,
+        uint64_t period )
+{
+    smx_timer_wheel_t* wheel = smx_timer_wheel_get();
+    if( wheel == NULL || timer == NULL || timer->callback == NULL )
+        return -1;
+
+    pthread_mutex_lock( &wheel->mutex );
+    if( timer->is_armed )
+    {
+        smx_timer_unlink( timer );
+    }
+    else
+    {
+        if( wheel->count == 0 )
+        {
+            // the idle wheel was not advanced, no timer needs to cascade
+            wheel->tick = smx_time_get_ns() / SMX_TIMER_WHEEL_TICK_NS;
+        }
+        wheel->count++;
+        timer->is_armed = true;
+    }
+    timer->deadline = deadline;
+    timer->period = period;
+    smx_timer_link( wheel, timer, wheel->tick + 1 );
+    if( wheel->count == 1 || timer->expiry < wheel->next_tick )
+    {
+        // the timer thread is idle or sleeps beyond the new expiry
+        pthread_cond_signal( &wheel->cv );
+    }
+    pthread_mutex_unlock( &wheel->mutex );
+    return 0;
+}
+
+/*****************************************************************************/
+void smx_timer_cancel( smx_timer_entry_t* timer )
+{
+    smx_timer_wheel_t* wheel = smx_timer_wheel;
+    if( wheel == NULL || timer == NULL )
+        return;
+
+    pthread_mutex_lock( &wheel->mutex );
+    if( timer->is_armed )
+    {
+        smx_timer_unlink( timer );
+        timer->is_armed = false;
+        wheel->count--;
+    }
+    pthread_mutex_unlock( &wheel->mutex );
+}
+
+/*****************************************************************************/
+void smx_timer_init( smx_timer_entry_t* timer, void callback( void* ),
+        void* arg )
+{
+    timer->deadline = 0;
+    timer->period = 0;
+    timer->expiry = 0;
+    timer->missed = 0;
+    timer->is_armed = false;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->slot = NULL;
+    timer->prev = NULL;
+    timer->next = NULL;
+}
+
+/*****************************************************************************/
+void smx_timer_wheel_cleanup()
+{
+    smx_timer_wheel_t* wheel;
+
+    pthread_mutex_lock( &smx_timer_wheel_mutex );
+    wheel = smx_timer_wheel;
+    smx_timer_wheel = NULL;
+    pthread_mutex_unlock( &smx_timer_wheel_mutex );
+    if( wheel == NULL )
+        return;
+
+    pthread_mutex_lock( &wheel->mutex );
+    wheel->is_running = false;
+    pthread_cond_signal( &wheel->cv );
+    pthread_mutex_unlock( &wheel->mutex );
+    pthread_join( wheel->thread, NULL );
+
+    if( wheel->count > 0 )
+    {
+        SMX_LOG_MAIN( main, warn, "%d timers still armed at cleanup",
+                wheel->count );
+    }
+    SMX_LOG_MAIN( main, notice, "timer wheel fired %lu timers", wheel->fired );
+    if( wheel->fired > 0 )
+    {
+        smx_hist_log( smx_get_zcat_main(), "timer jitter", &wheel->jitter );
+    }
+    pthread_mutex_destroy( &wheel->mutex );
+    pthread_cond_destroy( &wheel->cv );
+    free( wheel );
+}
@@ -19,3 +19,38 @@ void* smx_malloc( size_t size )
                 strerror( errno ) );
     return mem;
 }
+
+/*****************************************************************************/
+void smx_time_get_deadline( const struct timespec* timeout,
+        struct timespec* deadline )
+{
+    clock_gettime( CLOCK_MONOTONIC, deadline );
+    deadline->tv_sec += timeout->tv_sec;
+    deadline->tv_nsec += timeout->tv_nsec;
+    while( deadline->tv_nsec >= SMX_NSEC_PER_SEC )
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= SMX_NSEC_PER_SEC;
+    }
+}
+
+/*****************************************************************************/
+uint64_t smx_time_get_ns()
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return smx_time_timespec_to_ns( &now );
+}
+
+/*****************************************************************************/
+void smx_time_ns_to_timespec( uint64_t ns, struct timespec* ts )
+{
+    ts->tv_sec = ns / SMX_NSEC_PER_SEC;
+    ts->tv_nsec = ns % SMX_NSEC_PER_SEC;
+}
+
+/*****************************************************************************/
+uint64_t smx_time_timespec_to_ns( const struct timespec* ts )
+{
+    return ( uint64_t )ts->tv_sec * SMX_NSEC_PER_SEC + ts->tv_nsec;
+}